@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cmath>
+#include <stdint.h>
+
+// Accuracy/speed trade-off for the smooth activations.
+//   Exact    - libm tanhf/expf, reference accuracy
+//   Rational - clamped 7th order rational tanh, ~1e-4 abs error, no memory
+//   Table    - 512 entry table with linear interpolation, ~6e-5 abs error,
+//              2 KB of RAM built on first use
+enum class Approx : uint8_t {
+    Exact = 0,
+    Rational = 1,
+    Table = 2
+};
+
+namespace activation {
+
+const float GELU_C = 0.7978845608f;  // sqrt(2 / pi)
+const float GELU_K = 0.044715f;
+
+const int TANH_TABLE_SIZE = 512;
+const float TANH_TABLE_RANGE = 6.0f;
+
+inline float tanh_rational(float x) {
+    // Lambert continued fraction truncated after 7 terms; worst error
+    // is at the clamp edge where the true tanh is still below 1
+    x = x > 4.97f ? 4.97f : (x < -4.97f ? -4.97f : x);
+    float x2 = x * x;
+    float p = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+    float q = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
+    float y = p / q;
+    return y > 1.0f ? 1.0f : (y < -1.0f ? -1.0f : y);
+}
+
+struct TanhTable {
+    float values[TANH_TABLE_SIZE];
+    TanhTable() {
+        for (int i = 0; i < TANH_TABLE_SIZE; i++) {
+            float x = -TANH_TABLE_RANGE + 2.0f * TANH_TABLE_RANGE * i / (TANH_TABLE_SIZE - 1);
+            values[i] = tanhf(x);
+        }
+    }
+};
+
+inline const float* tanh_table() {
+    // Function-local static: built once, thread-safe on first use
+    static TanhTable table;
+    return table.values;
+}
+
+inline float tanh_lut(float x) {
+    const float* table = tanh_table();
+    const float scale = (TANH_TABLE_SIZE - 1) / (2.0f * TANH_TABLE_RANGE);
+    float pos = (x + TANH_TABLE_RANGE) * scale;
+    pos = pos < 0.0f ? 0.0f : (pos > TANH_TABLE_SIZE - 1.001f ? TANH_TABLE_SIZE - 1.001f : pos);
+    int i = (int)pos;
+    float frac = pos - (float)i;
+    return table[i] + frac * (table[i + 1] - table[i]);
+}
+
+inline float tanh_approx(float x, Approx a) {
+    switch (a) {
+        case Approx::Rational: return tanh_rational(x);
+        case Approx::Table: return tanh_lut(x);
+        default: return tanhf(x);
+    }
+}
+
+inline float sigmoid_approx(float x, Approx a) {
+    if (a == Approx::Exact) {
+        return 1.0f / (1.0f + expf(-x));
+    }
+    return 0.5f * tanh_approx(0.5f * x, a) + 0.5f;
+}
+
+// Row kernels. The switch is hoisted out of the loop so each loop body is
+// branch free and can be auto-vectorized where the target supports it.
+
+inline void tanh_row(const float* in, float* out, int n, Approx a) {
+    switch (a) {
+        case Approx::Rational:
+            for (int i = 0; i < n; i++) out[i] = tanh_rational(in[i]);
+            break;
+        case Approx::Table:
+            for (int i = 0; i < n; i++) out[i] = tanh_lut(in[i]);
+            break;
+        default:
+            for (int i = 0; i < n; i++) out[i] = tanhf(in[i]);
+            break;
+    }
+}
+
+inline void sigmoid_row(const float* in, float* out, int n, Approx a) {
+    if (a == Approx::Exact) {
+        for (int i = 0; i < n; i++) out[i] = 1.0f / (1.0f + expf(-in[i]));
+        return;
+    }
+    for (int i = 0; i < n; i++) out[i] = 0.5f * in[i];
+    tanh_row(out, out, n, a);
+    for (int i = 0; i < n; i++) out[i] = 0.5f * out[i] + 0.5f;
+}
+
+inline void silu_row(const float* in, float* out, int n, Approx a) {
+    sigmoid_row(in, out, n, a);
+    for (int i = 0; i < n; i++) out[i] *= in[i];
+}
+
+// tanh form of GELU
+inline void gelu_row(const float* in, float* out, int n, Approx a) {
+    for (int i = 0; i < n; i++) {
+        float x = in[i];
+        out[i] = GELU_C * (x + GELU_K * x * x * x);
+    }
+    tanh_row(out, out, n, a);
+    for (int i = 0; i < n; i++) out[i] = 0.5f * in[i] * (1.0f + out[i]);
+}
+
+}
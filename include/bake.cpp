@@ -0,0 +1,242 @@
+#include "bake.h"
+#include "codegen.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+
+// Relative step for slope sampling by central differences
+const float SLOPE_STEP = 1e-3f;
+// Interior points per segment checked when deciding to split
+const int PROBES = 3;
+// Dense-grid refinement passes after the probe phase
+const int REFINE_ROUNDS = 8;
+
+void sample_slopes(const BatchFn& f, const std::vector<float>& xs, float span, std::vector<float>& slopes) {
+    float h = span * SLOPE_STEP;
+    std::vector<float> in(2 * xs.size());
+    std::vector<float> out(in.size());
+    for (size_t i = 0; i < xs.size(); i++) {
+        in[2 * i] = xs[i] - h;
+        in[2 * i + 1] = xs[i] + h;
+    }
+    f(in.data(), out.data(), (int)in.size());
+    slopes.resize(xs.size());
+    for (size_t i = 0; i < xs.size(); i++) {
+        slopes[i] = (out[2 * i + 1] - out[2 * i]) / (2.0f * h);
+    }
+}
+
+}
+
+// Evaluate new knots (sorted, one per segment at most) and merge them in
+void insert_knots(const BatchFn& f, float span, const std::vector<float>& new_x, BakedLUT& lut) {
+    std::vector<float> new_y(new_x.size());
+    f(new_x.data(), new_y.data(), (int)new_x.size());
+
+    std::vector<float> xs;
+    std::vector<float> ys;
+    xs.reserve(lut.xs.size() + new_x.size());
+    ys.reserve(xs.capacity());
+    size_t n = 0;
+    for (size_t i = 0; i < lut.xs.size(); i++) {
+        xs.push_back(lut.xs[i]);
+        ys.push_back(lut.ys[i]);
+        if (n < new_x.size() && i + 1 < lut.xs.size() && new_x[n] < lut.xs[i + 1]) {
+            xs.push_back(new_x[n]);
+            ys.push_back(new_y[n]);
+            n++;
+        }
+    }
+    lut.xs.swap(xs);
+    lut.ys.swap(ys);
+    if (lut.interp == Interp::Cubic) {
+        sample_slopes(f, lut.xs, span, lut.slopes);
+    }
+}
+
+float BakedLUT::interpolate(int i, float x) const {
+    float x0 = xs[i];
+    float x1 = xs[i + 1];
+    float dx = x1 - x0;
+    float t = (x - x0) / dx;
+    if (interp == Interp::Linear) {
+        return ys[i] + t * (ys[i + 1] - ys[i]);
+    }
+    float t2 = t * t;
+    float t3 = t2 * t;
+    float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+    float h10 = t3 - 2.0f * t2 + t;
+    float h01 = -2.0f * t3 + 3.0f * t2;
+    float h11 = t3 - t2;
+    return h00 * ys[i] + h10 * dx * slopes[i] + h01 * ys[i + 1] + h11 * dx * slopes[i + 1];
+}
+
+int BakedLUT::segment(float x) const {
+    int b = (int)((x - xs.front()) * bucket_scale_);
+    b = b < 0 ? 0 : (b >= (int)buckets.size() ? (int)buckets.size() - 1 : b);
+    int i = buckets[b];
+    int last = (int)xs.size() - 2;
+    while (i < last && xs[i + 1] < x) {
+        i++;
+    }
+    return i;
+}
+
+float BakedLUT::operator()(float x) const {
+    float lo = xs.front();
+    float hi = xs.back();
+    x = x < lo ? lo : (x > hi ? hi : x);
+    return interpolate(segment(x), x);
+}
+
+void BakedLUT::build_buckets() {
+    // About two buckets per segment keeps the scan to a step or two
+    int segments = (int)xs.size() - 1;
+    int count = 1;
+    while (count < 2 * segments) {
+        count <<= 1;
+    }
+    buckets.assign(count, 0);
+    bucket_scale_ = (float)count / (xs.back() - xs.front());
+    int i = 0;
+    for (int b = 0; b < count; b++) {
+        float start = xs.front() + (float)b / bucket_scale_;
+        while (i < segments - 1 && xs[i + 1] <= start) {
+            i++;
+        }
+        buckets[b] = (uint16_t)i;
+    }
+}
+
+size_t BakedLUT::bytes() const {
+    return (xs.size() + ys.size() + slopes.size()) * sizeof(float) + buckets.size() * sizeof(uint16_t);
+}
+
+BakedLUT bake(const BatchFn& f, const BakeOptions& options) {
+    if (!(options.hi > options.lo) || options.max_knots < 2 || options.max_knots > 65535) {
+        throw std::invalid_argument("Invalid bake range or knot limit");
+    }
+    BakedLUT lut;
+    lut.interp = options.interp;
+    float span = options.hi - options.lo;
+
+    int initial = std::min(options.max_knots, 9);
+    lut.xs.resize(initial);
+    for (int i = 0; i < initial; i++) {
+        lut.xs[i] = options.lo + span * (float)i / (float)(initial - 1);
+    }
+    lut.ys.resize(initial);
+    f(lut.xs.data(), lut.ys.data(), initial);
+    if (lut.interp == Interp::Cubic) {
+        sample_slopes(f, lut.xs, span, lut.slopes);
+    }
+
+    // Split every segment whose probes miss the tolerance, one batch per round
+    while ((int)lut.xs.size() < options.max_knots) {
+        int segments = (int)lut.xs.size() - 1;
+        std::vector<float> probes(segments * PROBES);
+        std::vector<float> truth(probes.size());
+        for (int s = 0; s < segments; s++) {
+            for (int p = 0; p < PROBES; p++) {
+                float t = (float)(p + 1) / (float)(PROBES + 1);
+                probes[s * PROBES + p] = lut.xs[s] + t * (lut.xs[s + 1] - lut.xs[s]);
+            }
+        }
+        f(probes.data(), truth.data(), (int)probes.size());
+
+        std::vector<float> new_x;
+        for (int s = 0; s < segments; s++) {
+            float err = 0.0f;
+            for (int p = 0; p < PROBES; p++) {
+                int k = s * PROBES + p;
+                err = std::max(err, std::fabs(lut.interpolate(s, probes[k]) - truth[k]));
+            }
+            if (err > options.tolerance && (int)(lut.xs.size() + new_x.size()) < options.max_knots) {
+                new_x.push_back(0.5f * (lut.xs[s] + lut.xs[s + 1]));
+            }
+        }
+        if (new_x.empty()) {
+            break;
+        }
+        insert_knots(f, span, new_x, lut);
+    }
+
+    // Probes can miss narrow features (e.g. ReLU kinks), so check a dense
+    // grid and split the segments that still miss; the final pass reports
+    // the error the table actually achieves.
+    int n = std::max(options.check_points, 2);
+    std::vector<float> grid(n);
+    std::vector<float> truth(n);
+    for (int i = 0; i < n; i++) {
+        grid[i] = options.lo + span * (float)i / (float)(n - 1);
+    }
+    f(grid.data(), truth.data(), n);
+    for (int round = 0; ; round++) {
+        lut.build_buckets();
+        lut.max_error = 0.0f;
+        std::vector<float> new_x;
+        int last_split = -1;
+        for (int i = 0; i < n; i++) {
+            float err = std::fabs(lut(grid[i]) - truth[i]);
+            lut.max_error = std::max(lut.max_error, err);
+            int s = lut.segment(grid[i]);
+            if (err > options.tolerance && s != last_split
+                && (int)(lut.xs.size() + new_x.size()) < options.max_knots) {
+                new_x.push_back(0.5f * (lut.xs[s] + lut.xs[s + 1]));
+                last_split = s;
+            }
+        }
+        if (new_x.empty() || round == REFINE_ROUNDS) {
+            break;
+        }
+        insert_knots(f, span, new_x, lut);
+    }
+    return lut;
+}
+
+std::string BakedLUT::to_c_source(const char* name) const {
+    std::string n(name);
+    std::string out;
+    char buf[160];
+    snprintf(buf, sizeof(buf), "// Baked lookup table: %d knots, %s, max error %.3g\n",
+             knots(), interp == Interp::Cubic ? "cubic Hermite" : "linear", max_error);
+    out += buf;
+    out += "#include <stdint.h>\n\n";
+    codegen::append_array(out, "float", n + "_x", xs);
+    codegen::append_array(out, "float", n + "_y", ys);
+    if (interp == Interp::Cubic) {
+        codegen::append_array(out, "float", n + "_m", slopes);
+    }
+    out += "static const uint16_t " + n + "_bucket[" + std::to_string(buckets.size()) + "] = {";
+    for (size_t i = 0; i < buckets.size(); i++) {
+        out += (i % 12 == 0 ? "\n    " : " ") + std::to_string(buckets[i]) + (i + 1 < buckets.size() ? "," : "");
+    }
+    out += "\n};\n\n";
+
+    snprintf(buf, sizeof(buf), "float %s_eval(float x) {\n", name);
+    out += buf;
+    out += "    const float lo = " + codegen::float_literal(xs.front()) + ", hi = " + codegen::float_literal(xs.back())
+         + ", scale = " + codegen::float_literal(bucket_scale_) + ";\n";
+    out += "    x = x < lo ? lo : (x > hi ? hi : x);\n";
+    snprintf(buf, sizeof(buf), "    int b = (int)((x - lo) * scale);\n    if (b > %d) b = %d;\n",
+             (int)buckets.size() - 1, (int)buckets.size() - 1);
+    out += buf;
+    out += "    int i = " + n + "_bucket[b];\n";
+    snprintf(buf, sizeof(buf), "    while (i < %d && %s_x[i + 1] < x) i++;\n", knots() - 2, name);
+    out += buf;
+    out += "    float x0 = " + n + "_x[i], dx = " + n + "_x[i + 1] - x0, t = (x - x0) / dx;\n";
+    if (interp == Interp::Linear) {
+        out += "    return " + n + "_y[i] + t * (" + n + "_y[i + 1] - " + n + "_y[i]);\n";
+    } else {
+        out += "    float t2 = t * t, t3 = t2 * t;\n";
+        out += "    return (2.0f * t3 - 3.0f * t2 + 1.0f) * " + n + "_y[i]\n";
+        out += "         + (t3 - 2.0f * t2 + t) * dx * " + n + "_m[i]\n";
+        out += "         + (-2.0f * t3 + 3.0f * t2) * " + n + "_y[i + 1]\n";
+        out += "         + (t3 - t2) * dx * " + n + "_m[i + 1];\n";
+    }
+    out += "}\n";
+    return out;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+// "Baking" turns a trained scalar -> scalar model into an interpolated
+// lookup table. Knots are placed adaptively: a segment is split until
+// interpolation over it stays within the tolerance, so flat regions use
+// few knots and curved ones many. Evaluation is a bucket lookup plus a
+// short scan and one interpolation, with no model weights involved.
+
+enum class Interp : uint8_t {
+    Linear = 0,
+    Cubic = 1    // cubic Hermite with slopes sampled from the model
+};
+
+struct BakeOptions {
+    float lo;
+    float hi;
+    float tolerance;     // target max |lut(x) - f(x)|
+    int max_knots;       // hard cap on table size
+    Interp interp;
+    int check_points;    // dense grid used to report the final error
+
+    BakeOptions()
+        : lo(0.0f), hi(1.0f), tolerance(1e-3f), max_knots(1024),
+          interp(Interp::Linear), check_points(4096) {}
+};
+
+// Evaluates the model on n inputs at once
+typedef std::function<void(const float* xs, float* ys, int n)> BatchFn;
+
+class BakedLUT {
+public:
+    Interp interp;
+    std::vector<float> xs;          // knot positions, increasing
+    std::vector<float> ys;          // model value at each knot
+    std::vector<float> slopes;      // dy/dx at each knot (cubic only)
+    std::vector<uint16_t> buckets;  // first segment of each uniform bucket
+    float max_error;                // measured on the check grid
+
+    BakedLUT() : interp(Interp::Linear), max_error(0.0f), bucket_scale_(0.0f) {}
+
+    float operator()(float x) const;
+
+    int knots() const { return (int)xs.size(); }
+    size_t bytes() const;
+
+    // Standalone C source with const tables and a <name>_eval(float) function
+    std::string to_c_source(const char* name) const;
+
+private:
+    friend BakedLUT bake(const BatchFn& f, const BakeOptions& options);
+    friend void insert_knots(const BatchFn& f, float span, const std::vector<float>& new_x, BakedLUT& lut);
+
+    void build_buckets();
+    int segment(float x) const;
+    float interpolate(int segment, float x) const;
+
+    float bucket_scale_;
+};
+
+BakedLUT bake(const BatchFn& f, const BakeOptions& options);
@@ -0,0 +1,487 @@
+#include "codegen.h"
+#include <cctype>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+namespace codegen {
+
+std::string float_literal(float v) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", v);
+    std::string s(buf);
+    if (s.find_first_of(".eE") == std::string::npos) {
+        s += ".0";
+    }
+    return s + "f";
+}
+
+void append_array(std::string& out, const char* type, const std::string& name, const std::vector<float>& v) {
+    out += "static const " + std::string(type) + " " + name + "[" + std::to_string(v.size()) + "] = {";
+    for (size_t i = 0; i < v.size(); i++) {
+        out += (i % 6 == 0 ? "\n    " : " ") + float_literal(v[i]);
+        if (i + 1 < v.size()) {
+            out += ",";
+        }
+    }
+    out += "\n};\n";
+}
+
+}
+
+namespace {
+
+// Elements up to which a GEMM dot product is written out term by term
+const int UNROLL_K = 8;
+
+enum class NodeKind { Input, Const, Op };
+
+struct Node {
+    const Tensor* t;
+    NodeKind kind;
+    int left;
+    int right;
+    int uses;
+    std::string buf;   // row-major storage of the node in the generated C
+
+    Node(const Tensor* tensor, NodeKind k) : t(tensor), kind(k), left(-1), right(-1), uses(0) {}
+};
+
+template <typename T>
+void append_ints(std::string& out, const char* type, const std::string& name, const std::vector<T>& v) {
+    out += "static const " + std::string(type) + " " + name + "[" + std::to_string(v.size()) + "] = {";
+    for (size_t i = 0; i < v.size(); i++) {
+        out += (i % 12 == 0 ? "\n    " : " ") + std::to_string((long)v[i]) + (i + 1 < v.size() ? "," : "");
+    }
+    out += "\n};\n";
+}
+
+std::string sanitize(const std::string& s) {
+    std::string r;
+    for (size_t i = 0; i < s.size(); i++) {
+        char c = s[i];
+        if (std::isalnum((unsigned char)c)) {
+            r += c;
+        } else if (!r.empty() && r[r.size() - 1] != '_') {
+            r += '_';
+        }
+    }
+    while (!r.empty() && r[r.size() - 1] == '_') {
+        r.erase(r.size() - 1);
+    }
+    return r.empty() ? std::string("w") : r;
+}
+
+// Ops that write element i from element i of their left operand only
+bool is_elementwise(const Tensor* t) {
+    return t->op == OpId::LeakyRelu || t->op == OpId::Tanh || t->op == OpId::Sigmoid
+        || t->op == OpId::Gelu || t->op == OpId::Silu || t->op == OpId::BiasAdd;
+}
+
+class Emitter {
+public:
+    Emitter(const Tensor& output, const Tensor& input, const std::string& name)
+        : input_(&input), name_(name), tanh_rational_(false), tanh_table_(false) {
+        int root = collect(&output);
+        if (index_.find(input_) == index_.end()) {
+            throw std::invalid_argument("Output does not depend on the input");
+        }
+        assign_buffers(root);
+    }
+
+    std::string source(CodegenStats* stats) {
+        std::string body;
+        for (size_t i = 0; i < nodes_.size(); i++) {
+            if (nodes_[i].kind == NodeKind::Op) {
+                emit_op(nodes_[i], body);
+                stats_.ops++;
+            }
+        }
+        const Node& root = nodes_.back();
+        if (root.kind == NodeKind::Input) {
+            body += loop(count(root.t), "out[i] = in[i];");
+        }
+
+        std::string helper_src = helpers();
+        std::string out;
+        char buf[200];
+        snprintf(buf, sizeof(buf), "// Generated from a traced graph: %d ops, %u bytes const, %u bytes scratch\n",
+                 stats_.ops, (unsigned)stats_.const_bytes, (unsigned)stats_.scratch_bytes);
+        out += buf;
+        snprintf(buf, sizeof(buf), "// in: %d x %d floats, out: %d x %d floats, row-major\n",
+                 input_->rows, input_->cols, root.t->rows, root.t->cols);
+        out += buf;
+        out += "#include <math.h>\n#include <stdint.h>\n\n";
+        out += consts_;
+        out += helper_src;
+        if (!scratch_.empty()) {
+            out += "\n" + scratch_;
+        }
+        out += "\nvoid " + name_ + "_predict(const float* in, float* out) {\n";
+        out += body;
+        out += "}\n";
+        if (stats) {
+            *stats = stats_;
+        }
+        return out;
+    }
+
+private:
+    int collect(const Tensor* t) {
+        std::map<const Tensor*, int>::iterator it = index_.find(t);
+        if (it != index_.end()) {
+            return it->second;
+        }
+        NodeKind kind = t == input_ ? NodeKind::Input
+                      : t->op == OpId::Leaf ? NodeKind::Const : NodeKind::Op;
+        int left = -1, right = -1;
+        if (kind == NodeKind::Op) {
+            // backward() releases the children of every node it visits
+            if (!t->left) {
+                throw std::invalid_argument("Graph already consumed by backward; trace a fresh forward pass");
+            }
+            if (t->left) {
+                left = collect(t->left.get());
+            }
+            if (t->right) {
+                right = collect(t->right.get());
+            }
+        }
+        nodes_.push_back(Node(t, kind));
+        Node& n = nodes_.back();
+        n.left = left;
+        n.right = right;
+        if (left >= 0) {
+            nodes_[left].uses++;
+        }
+        if (right >= 0) {
+            nodes_[right].uses++;
+        }
+        index_[t] = (int)nodes_.size() - 1;
+        if (kind == NodeKind::Input) {
+            n.buf = "in";
+        } else if (kind == NodeKind::Const) {
+            emit_const(n);
+        }
+        return (int)nodes_.size() - 1;
+    }
+
+    // Walk back from the output so an elementwise op can hand its buffer to
+    // an operand nobody else reads, and then run in place.
+    void assign_buffers(int root) {
+        if (nodes_[root].kind == NodeKind::Op) {
+            nodes_[root].buf = "out";
+        }
+        for (int i = root; i >= 0; i--) {
+            Node& n = nodes_[i];
+            if (n.kind != NodeKind::Op) {
+                continue;
+            }
+            if (n.buf.empty()) {
+                n.buf = name_ + "_t" + std::to_string(i);
+                scratch_ += "static float " + n.buf + "[" + std::to_string(count(n.t)) + "];\n";
+                stats_.scratch_bytes += count(n.t) * sizeof(float);
+            }
+            if (is_elementwise(n.t) && n.left >= 0) {
+                Node& in = nodes_[n.left];
+                if (in.kind == NodeKind::Op && in.uses == 1 && in.buf.empty()) {
+                    in.buf = n.buf;
+                }
+            }
+        }
+    }
+
+    void emit_const(Node& n) {
+        std::string base = name_ + "_" + sanitize(n.t->label());
+        std::string cname = base;
+        for (int k = 2; used_names_.count(cname); k++) {
+            cname = base + "_" + std::to_string(k);
+        }
+        used_names_.insert(cname);
+        n.buf = cname;
+
+        if (n.t->sparse) {
+            const CSRMatrix& s = *n.t->sparse;
+            codegen::append_array(consts_, "float", cname + "_val", s.values);
+            append_ints(consts_, "uint16_t", cname + "_col", s.col_idx);
+            append_ints(consts_, "int32_t", cname + "_ptr", s.row_ptr);
+            stats_.const_bytes += s.bytes();
+            return;
+        }
+        std::vector<float> flat;
+        flat.reserve(count(n.t));
+        for (int i = 0; i < n.t->rows; i++) {
+            flat.insert(flat.end(), n.t->data[i], n.t->data[i] + n.t->cols);
+        }
+        codegen::append_array(consts_, "float", cname, flat);
+        stats_.const_bytes += flat.size() * sizeof(float);
+    }
+
+    void emit_op(const Node& n, std::string& out) {
+        const Tensor* t = n.t;
+        const std::string& c = n.buf;
+        std::string a = n.left >= 0 ? nodes_[n.left].buf : "";
+        std::string b = n.right >= 0 ? nodes_[n.right].buf : "";
+        int size = count(t);
+        char line[64];
+        snprintf(line, sizeof(line), "    // %s %dx%d\n", op_symbol(t->op), t->rows, t->cols);
+        out += line;
+
+        if (t->op != OpId::Mul && (is_sparse_const(n.left) || is_sparse_const(n.right))) {
+            throw std::invalid_argument("Pruned tensors can only be exported as matmul operands");
+        }
+        switch (t->op) {
+            case OpId::Mul:
+                emit_matmul(n, out);
+                break;
+            case OpId::Add:
+                out += loop(size, c + "[i] = " + a + "[i] + " + b + "[i];");
+                break;
+            case OpId::Sub:
+                out += loop(size, c + "[i] = " + a + "[i] - " + b + "[i];");
+                break;
+            case OpId::Div:
+                out += loop(size, c + "[i] = " + a + "[i] / " + b + "[i];");
+                break;
+            case OpId::BiasAdd:
+                out += "    for (int i = 0; i < " + std::to_string(t->rows) + "; i++) {\n";
+                out += "        for (int j = 0; j < " + std::to_string(t->cols) + "; j++) " + c + "[i * "
+                     + std::to_string(t->cols) + " + j] = " + a + "[i * " + std::to_string(t->cols) + " + j] + "
+                     + b + "[j];\n";
+                out += "    }\n";
+                break;
+            case OpId::Conv1d:
+                emit_conv1d(n, out);
+                break;
+            case OpId::Dot:
+                out += "    {\n        float acc = 0.0f;\n";
+                out += "        for (int i = 0; i < " + std::to_string(nodes_[n.left].t->rows) + "; i++) acc += "
+                     + a + "[i] * " + b + "[i];\n";
+                out += "        " + c + "[0] = acc;\n    }\n";
+                break;
+            case OpId::LeakyRelu:
+                out += loop(size, c + "[i] = " + a + "[i] > 0.0f ? " + a + "[i] : "
+                            + codegen::float_literal(t->attrs.alpha) + " * " + a + "[i];");
+                break;
+            case OpId::Tanh:
+                out += loop(size, c + "[i] = " + tanh_call(a + "[i]", t->attrs.approx) + ";");
+                break;
+            case OpId::Sigmoid:
+                out += loop(size, c + "[i] = " + sigmoid_expr(a + "[i]", t->attrs.approx) + ";");
+                break;
+            case OpId::Silu:
+                out += loop(size, "float x = " + a + "[i]; " + c + "[i] = x * "
+                            + sigmoid_expr("x", t->attrs.approx) + ";");
+                break;
+            case OpId::Gelu: {
+                std::string u = codegen::float_literal(activation::GELU_C) + " * (x + "
+                              + codegen::float_literal(activation::GELU_K) + " * x * x * x)";
+                out += loop(size, "float x = " + a + "[i]; " + c + "[i] = 0.5f * x * (1.0f + "
+                            + tanh_call(u, t->attrs.approx) + ");");
+                break;
+            }
+            case OpId::Sum:
+            case OpId::Mean: {
+                int in_size = count(nodes_[n.left].t);
+                out += "    {\n        float acc = 0.0f;\n";
+                out += "        for (int i = 0; i < " + std::to_string(in_size) + "; i++) acc += " + a + "[i];\n";
+                if (t->op == OpId::Mean) {
+                    out += "        " + c + "[0] = acc / " + codegen::float_literal((float)in_size) + ";\n    }\n";
+                } else {
+                    out += "        " + c + "[0] = acc;\n    }\n";
+                }
+                break;
+            }
+            case OpId::Mse:
+                throw std::invalid_argument("Loss nodes cannot be exported; trace the model output");
+            case OpId::Checkpoint:
+                throw std::invalid_argument("Checkpointed segments cannot be exported; trace without checkpoint");
+            default:
+                throw std::invalid_argument(std::string("Unsupported op in exported graph: ") + op_symbol(t->op));
+        }
+    }
+
+    // Direct loops; the window offsets are literals, padding taps are skipped
+    void emit_conv1d(const Node& n, std::string& out) {
+        const Tensor* in = nodes_[n.left].t;
+        const OpAttrs& at = n.t->attrs;
+        const std::string& a = nodes_[n.left].buf;
+        const std::string& w = nodes_[n.right].buf;
+        const std::string& c = n.buf;
+        int channels = in->cols, outs = n.t->cols;
+        char line[256];
+        snprintf(line, sizeof(line), "    for (int t = 0; t < %d; t++) {\n", n.t->rows);
+        out += line;
+        snprintf(line, sizeof(line), "        float* cr = %s + t * %d;\n", c.c_str(), outs);
+        out += line;
+        snprintf(line, sizeof(line), "        for (int j = 0; j < %d; j++) cr[j] = 0.0f;\n", outs);
+        out += line;
+        snprintf(line, sizeof(line), "        for (int k = 0; k < %d; k++) {\n", at.kernel_size);
+        out += line;
+        snprintf(line, sizeof(line), "            int s = t * %d - %d + k * %d;\n", at.stride, at.padding, at.dilation);
+        out += line;
+        snprintf(line, sizeof(line), "            if (s < 0 || s >= %d) continue;\n", in->rows);
+        out += line;
+        snprintf(line, sizeof(line), "            for (int ch = 0; ch < %d; ch++) {\n", channels);
+        out += line;
+        snprintf(line, sizeof(line), "                float av = %s[s * %d + ch];\n", a.c_str(), channels);
+        out += line;
+        snprintf(line, sizeof(line), "                const float* wr = %s + (k * %d + ch) * %d;\n", w.c_str(), channels, outs);
+        out += line;
+        snprintf(line, sizeof(line), "                for (int j = 0; j < %d; j++) cr[j] += av * wr[j];\n", outs);
+        out += line;
+        out += "            }\n        }\n    }\n";
+    }
+
+    void emit_matmul(const Node& n, std::string& out) {
+        const Node& ln = nodes_[n.left];
+        const Node& rn = nodes_[n.right];
+        const std::string& a = ln.buf;
+        const std::string& b = rn.buf;
+        const std::string& c = n.buf;
+        int R = ln.t->rows, K = ln.t->cols, N = rn.t->cols;
+        std::string sR = std::to_string(R), sK = std::to_string(K), sN = std::to_string(N);
+        char line[256];
+
+        if (rn.kind == NodeKind::Const && rn.t->sparse) {
+            out += "    for (int i = 0; i < " + sR + "; i++) {\n";
+            out += "        for (int j = 0; j < " + sN + "; j++) " + c + "[i * " + sN + " + j] = 0.0f;\n";
+            out += "        for (int k = 0; k < " + sK + "; k++) {\n";
+            out += "            float av = " + a + "[i * " + sK + " + k];\n";
+            snprintf(line, sizeof(line), "            for (int p = %s_ptr[k]; p < %s_ptr[k + 1]; p++) "
+                     "%s[i * %d + %s_col[p]] += av * %s_val[p];\n",
+                     b.c_str(), b.c_str(), c.c_str(), N, b.c_str(), b.c_str());
+            out += line;
+            out += "        }\n    }\n";
+            return;
+        }
+        if (ln.kind == NodeKind::Const && ln.t->sparse) {
+            out += "    for (int i = 0; i < " + sR + "; i++) {\n";
+            out += "        for (int j = 0; j < " + sN + "; j++) " + c + "[i * " + sN + " + j] = 0.0f;\n";
+            snprintf(line, sizeof(line), "        for (int p = %s_ptr[i]; p < %s_ptr[i + 1]; p++) {\n",
+                     a.c_str(), a.c_str());
+            out += line;
+            out += "            float av = " + a + "_val[p];\n";
+            out += "            const float* br = " + b + " + " + a + "_col[p] * " + sN + ";\n";
+            out += "            for (int j = 0; j < " + sN + "; j++) " + c + "[i * " + sN + " + j] += av * br[j];\n";
+            out += "        }\n    }\n";
+            return;
+        }
+        if (K <= UNROLL_K) {
+            // Short dot products are written out with literal offsets
+            std::string sum;
+            for (int k = 0; k < K; k++) {
+                sum += (k ? " + " : "") + a + "[i * " + sK + " + " + std::to_string(k) + "] * "
+                     + b + "[" + std::to_string(k * N) + " + j]";
+            }
+            out += "    for (int i = 0; i < " + sR + "; i++) {\n";
+            out += "        for (int j = 0; j < " + sN + "; j++) {\n";
+            out += "            " + c + "[i * " + sN + " + j] = " + sum + ";\n";
+            out += "        }\n    }\n";
+            return;
+        }
+        if (N == 1) {
+            out += "    for (int i = 0; i < " + sR + "; i++) {\n";
+            out += "        float acc = 0.0f;\n";
+            out += "        for (int k = 0; k < " + sK + "; k++) acc += " + a + "[i * " + sK + " + k] * " + b + "[k];\n";
+            out += "        " + c + "[i] = acc;\n    }\n";
+            return;
+        }
+        // i-k-j order: contiguous rows of b, vectorizable inner loop
+        out += "    for (int i = 0; i < " + sR + "; i++) {\n";
+        out += "        float* cr = " + c + " + i * " + sN + ";\n";
+        out += "        for (int j = 0; j < " + sN + "; j++) cr[j] = 0.0f;\n";
+        out += "        for (int k = 0; k < " + sK + "; k++) {\n";
+        out += "            float av = " + a + "[i * " + sK + " + k];\n";
+        out += "            const float* br = " + b + " + k * " + sN + ";\n";
+        out += "            for (int j = 0; j < " + sN + "; j++) cr[j] += av * br[j];\n";
+        out += "        }\n    }\n";
+    }
+
+    std::string tanh_call(const std::string& x, Approx approx) {
+        switch (approx) {
+            case Approx::Rational:
+                tanh_rational_ = true;
+                return name_ + "_tanh_rational(" + x + ")";
+            case Approx::Table:
+                tanh_table_ = true;
+                return name_ + "_tanh_table(" + x + ")";
+            default:
+                return "tanhf(" + x + ")";
+        }
+    }
+
+    // Parenthesized so it can be used as an operand, e.g. x * sigmoid
+    std::string sigmoid_expr(const std::string& x, Approx approx) {
+        if (approx == Approx::Exact) {
+            return "(1.0f / (1.0f + expf(-" + x + ")))";
+        }
+        return "(0.5f * " + tanh_call("0.5f * " + x, approx) + " + 0.5f)";
+    }
+
+    // Same formulas as activation.h, so the export matches the trained model
+    std::string helpers() {
+        std::string out;
+        if (tanh_rational_) {
+            out += "\nstatic inline float " + name_ + "_tanh_rational(float x) {\n"
+                   "    x = x > 4.97f ? 4.97f : (x < -4.97f ? -4.97f : x);\n"
+                   "    float x2 = x * x;\n"
+                   "    float p = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));\n"
+                   "    float q = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));\n"
+                   "    float y = p / q;\n"
+                   "    return y > 1.0f ? 1.0f : (y < -1.0f ? -1.0f : y);\n"
+                   "}\n";
+        }
+        if (tanh_table_) {
+            const float* table = activation::tanh_table();
+            std::vector<float> values(table, table + activation::TANH_TABLE_SIZE);
+            out += "\n";
+            codegen::append_array(out, "float", name_ + "_tanh_lut", values);
+            stats_.const_bytes += values.size() * sizeof(float);
+            const float scale = (activation::TANH_TABLE_SIZE - 1) / (2.0f * activation::TANH_TABLE_RANGE);
+            out += "\nstatic inline float " + name_ + "_tanh_table(float x) {\n";
+            out += "    float pos = (x + " + codegen::float_literal(activation::TANH_TABLE_RANGE) + ") * "
+                 + codegen::float_literal(scale) + ";\n";
+            out += "    const float hi = " + codegen::float_literal(activation::TANH_TABLE_SIZE - 1.001f) + ";\n";
+            out += "    pos = pos < 0.0f ? 0.0f : (pos > hi ? hi : pos);\n";
+            out += "    int i = (int)pos;\n";
+            out += "    float frac = pos - (float)i;\n";
+            out += "    return " + name_ + "_tanh_lut[i] + frac * (" + name_ + "_tanh_lut[i + 1] - "
+                 + name_ + "_tanh_lut[i]);\n";
+            out += "}\n";
+        }
+        return out;
+    }
+
+    bool is_sparse_const(int i) const {
+        return i >= 0 && nodes_[i].kind == NodeKind::Const && nodes_[i].t->sparse;
+    }
+
+    static std::string loop(int n, const std::string& stmt) {
+        return "    for (int i = 0; i < " + std::to_string(n) + "; i++) { " + stmt + " }\n";
+    }
+
+    static int count(const Tensor* t) {
+        return t->rows * t->cols;
+    }
+
+    const Tensor* input_;
+    std::string name_;
+    std::vector<Node> nodes_;
+    std::map<const Tensor*, int> index_;
+    std::set<std::string> used_names_;
+    std::string consts_;
+    std::string scratch_;
+    bool tanh_rational_;
+    bool tanh_table_;
+    CodegenStats stats_;
+};
+
+}
+
+std::string generate_c_source(const Tensor& output, const Tensor& input, const char* name,
+                              CodegenStats* stats) {
+    Emitter emitter(output, input, sanitize(name));
+    return emitter.source(stats);
+}
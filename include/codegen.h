@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "matrix.h"
+
+// Ahead-of-time export of a traced inference graph to standalone C.
+// Trace the model once on an input of the deployment shape, then pass the
+// output and input tensors. Leaves other than the input become static
+// const arrays (rodata, so flash on the ESP32); pruned leaves are written
+// in CSR form. Every op turns into a loop nest with literal bounds that
+// works on file-scope scratch buffers, so the generated
+// <name>_predict(const float* in, float* out) never allocates. Inputs and
+// outputs are row-major. The scratch buffers make predict non-reentrant.
+
+struct CodegenStats {
+    size_t const_bytes;    // weights and tables in rodata
+    size_t scratch_bytes;  // intermediate buffers in bss
+    int ops;
+
+    CodegenStats() : const_bytes(0), scratch_bytes(0), ops(0) {}
+};
+
+std::string generate_c_source(const Tensor& output, const Tensor& input, const char* name,
+                              CodegenStats* stats = nullptr);
+
+namespace codegen {
+
+// %.9g literal that round-trips a float and stays a float in C
+std::string float_literal(float v);
+
+// "static const <type> <name>[n] = {...};" with six values per line
+void append_array(std::string& out, const char* type, const std::string& name, const std::vector<float>& v);
+
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <vector>
+#include "value.h"
+#include "parameters.h"
+#include "scheduler.h"
+
+// Data-parallel training. Every worker owns a replica of the parameters
+// and builds its own graph over a shard of the batch, so forward and
+// backward run with no shared state. The replica gradients are then
+// all-reduced into the master registry: the flat gradient array is cut
+// into one slice per worker, and each worker sums its slice across all
+// replicas. The master takes the SGD step and the replicas copy it back
+// before the next batch.
+class DataParallelTrainer {
+public:
+    // Builds the loss of one shard from that worker's parameter replicas
+    typedef std::function<Value(Value &x, Value &y, std::vector<Value> &params)> LossFn;
+
+    DataParallelTrainer(LossFn loss_fn, ParameterRegistry &master, int workers)
+        : loss_fn_(loss_fn), master_(master), pool_(workers), workers_(workers), replicas_(workers)
+    {
+        for (int w = 0; w < workers_; w++) {
+            Replica &r = replicas_[w];
+            for (int i = 0; i < master_.count(); i++) {
+                Tensor *t = master_.tensor(i);
+                Value v(t->rows, t->cols, t->data, t->label());
+                if (t->sparse) {
+                    v.orig->sparse = std::make_shared<CSRMatrix>(*t->sparse);
+                }
+                r.params.push_back(v);
+            }
+            for (size_t i = 0; i < r.params.size(); i++) {
+                r.registry.add(r.params[i]);
+            }
+            r.registry.pack();
+        }
+    }
+
+    // One synchronous step over the full batch; returns the mean loss
+    float step(const Tensor &x, const Tensor &y, float learning_rate)
+    {
+        int rows = x.rows;
+        for (int w = 0; w < workers_; w++) {
+            Replica &r = replicas_[w];
+            r.begin = rows * w / workers_;
+            r.count = rows * (w + 1) / workers_ - r.begin;
+            r.registry.load(master_);
+            pool_.submit([this, w, &x, &y] { run_shard(w, x, y); });
+        }
+        pool_.wait();
+
+        // Each worker reduces one slice of the flat gradient array.
+        // Shard losses are means, so weight each replica by its share of rows.
+        size_t n = master_.size();
+        for (int w = 0; w < workers_; w++) {
+            size_t lo = n * w / workers_;
+            size_t hi = n * (w + 1) / workers_;
+            pool_.submit([this, lo, hi, rows] { reduce_slice(lo, hi, rows); });
+        }
+        pool_.wait();
+
+        master_.step(learning_rate);
+        master_.zero_grad();
+
+        float loss = 0.0f;
+        for (int w = 0; w < workers_; w++) {
+            loss += replicas_[w].loss * (float)replicas_[w].count / (float)rows;
+        }
+        return loss;
+    }
+
+    int workers() const { return workers_; }
+
+private:
+    struct Replica {
+        std::vector<Value> params;
+        ParameterRegistry registry;
+        int begin;
+        int count;
+        float loss;
+        Replica() : begin(0), count(0), loss(0.0f) {}
+    };
+
+    void run_shard(int w, const Tensor &x, const Tensor &y)
+    {
+        Replica &r = replicas_[w];
+        r.loss = 0.0f;
+        if (r.count == 0) {
+            return;
+        }
+        Value xs(Tensor::slice_rows(x, r.begin, r.count));
+        Value ys(Tensor::slice_rows(y, r.begin, r.count));
+        Value loss = loss_fn_(xs, ys, r.params);
+        loss.backward();
+        r.loss = loss.item();
+    }
+
+    void reduce_slice(size_t lo, size_t hi, int rows)
+    {
+        float32 *__restrict g = master_.grad();
+        for (int w = 0; w < workers_; w++) {
+            Replica &r = replicas_[w];
+            float32 scale = (float32)r.count / (float32)rows;
+            const float32 *__restrict rg = r.registry.grad();
+            for (size_t i = lo; i < hi; i++) {
+                g[i] += scale * rg[i];
+            }
+            memset(r.registry.grad() + lo, 0, (hi - lo) * sizeof(float32));
+        }
+    }
+
+    LossFn loss_fn_;
+    ParameterRegistry &master_;
+    WorkStealingPool pool_;
+    int workers_;
+    std::vector<Replica> replicas_;
+};
+
+struct ScalingPoint {
+    int workers;
+    float ms_per_step;
+    float speedup;      // relative to one worker
+    float efficiency;   // speedup / workers
+};
+
+// Time `steps` data-parallel steps for 1..max_workers workers. Runs with a
+// zero learning rate, so the master parameters are left unchanged.
+inline std::vector<ScalingPoint> measure_scaling(DataParallelTrainer::LossFn loss_fn,
+                                                 ParameterRegistry &master,
+                                                 const Tensor &x, const Tensor &y,
+                                                 int max_workers, int steps)
+{
+    std::vector<ScalingPoint> points;
+    float base = 0.0f;
+    for (int w = 1; w <= max_workers; w++) {
+        DataParallelTrainer trainer(loss_fn, master, w);
+        trainer.step(x, y, 0.0f);  // warm up
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < steps; i++) {
+            trainer.step(x, y, 0.0f);
+        }
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        ScalingPoint p;
+        p.workers = w;
+        p.ms_per_step = elapsed.count() / (float)steps;
+        if (w == 1) {
+            base = p.ms_per_step;
+        }
+        p.speedup = p.ms_per_step > 0.0f ? base / p.ms_per_step : 0.0f;
+        p.efficiency = p.speedup / (float)w;
+        points.push_back(p);
+    }
+    return points;
+}
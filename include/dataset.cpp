@@ -0,0 +1,225 @@
+#include "dataset.h"
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_partition.h>
+#include <esp_spi_flash.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t HEADER_SIZE = 16;
+const size_t FIELD_ENTRY_SIZE = DATASET_NAME_LEN + 8;
+
+uint32_t read_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool write_u32(FILE* f, uint32_t v) {
+    uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+    return fwrite(b, 1, 4, f) == 4;
+}
+
+}
+
+bool write_dataset(const char* path, int rows, const std::vector<DatasetField>& fields) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = fwrite(DATASET_MAGIC, 1, 4, f) == 4
+           && write_u32(f, DATASET_VERSION)
+           && write_u32(f, (uint32_t)rows)
+           && write_u32(f, (uint32_t)fields.size());
+
+    size_t offset = HEADER_SIZE + fields.size() * FIELD_ENTRY_SIZE;
+    for (size_t i = 0; ok && i < fields.size(); i++) {
+        char name[DATASET_NAME_LEN] = {0};
+        strncpy(name, fields[i].name.c_str(), DATASET_NAME_LEN - 1);
+        ok = fwrite(name, 1, DATASET_NAME_LEN, f) == (size_t)DATASET_NAME_LEN
+          && write_u32(f, (uint32_t)fields[i].width)
+          && write_u32(f, (uint32_t)offset);
+        offset += (size_t)rows * fields[i].width * sizeof(float32);
+    }
+    // Field blocks are written in order, so offsets need no padding
+    for (size_t i = 0; ok && i < fields.size(); i++) {
+        size_t n = (size_t)rows * fields[i].width;
+        ok = fwrite(fields[i].data, sizeof(float32), n, f) == n;
+    }
+    return fclose(f) == 0 && ok;
+}
+
+MappedDataset::MappedDataset()
+    : base_(nullptr), size_(0), rows_(0)
+#ifdef ESP_PLATFORM
+    , mmap_handle_(0)
+#else
+    , fd_(-1)
+#endif
+{}
+
+MappedDataset::~MappedDataset() {
+    close();
+}
+
+bool MappedDataset::open(const char* source) {
+    close();
+#ifdef ESP_PLATFORM
+    const esp_partition_t* part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, source);
+    if (!part) {
+        return false;
+    }
+    const void* ptr = nullptr;
+    spi_flash_mmap_handle_t handle;
+    if (esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA, &ptr, &handle) != ESP_OK) {
+        return false;
+    }
+    base_ = static_cast<const uint8_t*>(ptr);
+    size_ = part->size;
+    mmap_handle_ = handle;
+#else
+    fd_ = ::open(source, O_RDONLY);
+    if (fd_ < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || st.st_size < (off_t)HEADER_SIZE) {
+        close();
+        return false;
+    }
+    void* ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (ptr == MAP_FAILED) {
+        close();
+        return false;
+    }
+    base_ = static_cast<const uint8_t*>(ptr);
+    size_ = (size_t)st.st_size;
+#endif
+    if (!parse()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedDataset::close() {
+    if (base_) {
+#ifdef ESP_PLATFORM
+        spi_flash_munmap(mmap_handle_);
+#else
+        munmap(const_cast<uint8_t*>(base_), size_);
+#endif
+    }
+#ifndef ESP_PLATFORM
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+#endif
+    base_ = nullptr;
+    size_ = 0;
+    rows_ = 0;
+    fields_.clear();
+}
+
+// Every size read from the file is untrusted: dimensions must fit an int
+// and all byte arithmetic is checked against SIZE_MAX before it is
+// compared with the mapping size.
+bool MappedDataset::parse() {
+    if (size_ < HEADER_SIZE || memcmp(base_, DATASET_MAGIC, 4) != 0 || read_u32(base_ + 4) != DATASET_VERSION) {
+        return false;
+    }
+    uint32_t rows = read_u32(base_ + 8);
+    uint32_t num_fields = read_u32(base_ + 12);
+    if (rows > (uint32_t)INT_MAX || num_fields > (size_ - HEADER_SIZE) / FIELD_ENTRY_SIZE) {
+        return false;
+    }
+    rows_ = (int)rows;
+    for (uint32_t i = 0; i < num_fields; i++) {
+        const uint8_t* entry = base_ + HEADER_SIZE + i * FIELD_ENTRY_SIZE;
+        uint32_t width = read_u32(entry + DATASET_NAME_LEN);
+        uint32_t offset = read_u32(entry + DATASET_NAME_LEN + 4);
+        if (width == 0 || width > (uint32_t)INT_MAX || offset % sizeof(float32) != 0 || offset > size_) {
+            return false;
+        }
+        // rows * width * 4 <= size_ - offset, without overflowing size_t
+        size_t avail = (size_ - offset) / sizeof(float32);
+        if (rows != 0 && width > avail / rows) {
+            return false;
+        }
+        Field field;
+        field.name = std::string((const char*)entry, strnlen((const char*)entry, DATASET_NAME_LEN));
+        field.width = (int)width;
+        field.data = reinterpret_cast<const float32*>(base_ + offset);
+        fields_.push_back(field);
+    }
+    return true;
+}
+
+int MappedDataset::field_index(const char* name) const {
+    for (size_t i = 0; i < fields_.size(); i++) {
+        if (fields_[i].name == name) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+Tensor* MappedDataset::view(int field, int row_begin, int row_count) const {
+    if (field < 0 || field >= (int)fields_.size() || row_begin < 0 || row_count < 0
+        || row_count > rows_ - row_begin) {
+        throw std::invalid_argument("Dataset view out of range");
+    }
+    const Field& f = fields_[field];
+    // Ops only read their inputs, so the read-only mapping is never written
+    float32* base = const_cast<float32*>(f.data) + (size_t)row_begin * f.width;
+    return Tensor::view(row_count, f.width, base, f.width, f.name, false);
+}
+
+void MappedDataset::prefetch(int row_begin, int row_count) const {
+#ifdef ESP_PLATFORM
+    (void)row_begin;
+    (void)row_count;
+#else
+    if (row_count <= 0) {
+        return;
+    }
+    long page = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < fields_.size(); i++) {
+        const uint8_t* start = reinterpret_cast<const uint8_t*>(fields_[i].data + (size_t)row_begin * fields_[i].width);
+        size_t len = (size_t)row_count * fields_[i].width * sizeof(float32);
+        uintptr_t aligned = (uintptr_t)start & ~(uintptr_t)(page - 1);
+        madvise(reinterpret_cast<void*>(aligned), len + ((uintptr_t)start - aligned), MADV_WILLNEED);
+    }
+#endif
+}
+
+ChunkLoader::ChunkLoader(const MappedDataset& dataset, int chunk_rows)
+    : dataset_(dataset), chunk_rows_(chunk_rows), begin_(-1), count_(0) {
+    if (chunk_rows < 1) {
+        // A zero-row chunk never advances, so next() would spin forever
+        throw std::invalid_argument("Chunk size must be at least one row");
+    }
+}
+
+bool ChunkLoader::next() {
+    int start = begin_ < 0 ? 0 : begin_ + count_;
+    if (start >= dataset_.rows()) {
+        return false;
+    }
+    begin_ = start;
+    count_ = dataset_.rows() - start < chunk_rows_ ? dataset_.rows() - start : chunk_rows_;
+
+    int ahead = begin_ + count_;
+    int ahead_count = dataset_.rows() - ahead < chunk_rows_ ? dataset_.rows() - ahead : chunk_rows_;
+    dataset_.prefetch(ahead, ahead_count);
+    return true;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "matrix.h"
+
+// Columnar binary dataset (little-endian, float32):
+//
+//   char     magic[4]      "NNDS"
+//   uint32_t version       1
+//   uint32_t rows
+//   uint32_t num_fields
+//   num_fields x {
+//     char     name[16]    zero padded
+//     uint32_t width       floats per row
+//     uint32_t offset      byte offset of the field block, 4-byte aligned
+//   }
+//   field blocks           rows x width floats, row-major within a field
+//
+// Each field ("x", "y", ...) is one contiguous block, so a range of rows
+// of a field is a strided slice of the mapped file and can be handed to
+// the graph as a Tensor view without copying.
+
+const char DATASET_MAGIC[4] = {'N', 'N', 'D', 'S'};
+const uint32_t DATASET_VERSION = 1;
+const int DATASET_NAME_LEN = 16;
+
+struct DatasetField {
+    std::string name;
+    int width;
+    const float32* data;   // rows x width, row-major
+};
+
+// Write a dataset file. Returns false on I/O error.
+bool write_dataset(const char* path, int rows, const std::vector<DatasetField>& fields);
+
+class MappedDataset {
+public:
+    MappedDataset();
+    ~MappedDataset();
+
+    // Linux: path of the dataset file, mapped with mmap.
+    // ESP32: label of a data partition, mapped through the flash MMU.
+    bool open(const char* source);
+    void close();
+
+    bool is_open() const { return base_ != nullptr; }
+    int rows() const { return rows_; }
+    int num_fields() const { return (int)fields_.size(); }
+    int field_index(const char* name) const;
+    int width(int field) const { return fields_[field].width; }
+    const float32* field_data(int field) const { return fields_[field].data; }
+
+    // Zero-copy view of rows [row_begin, row_begin + row_count) of a field.
+    // Dataset rows are inputs, so the view carries no grad buffer.
+    Tensor* view(int field, int row_begin, int row_count) const;
+
+    // Hint that a row range will be read soon. On Linux the kernel starts
+    // reading it in the background; on ESP32 flash is read through the
+    // MMU cache on demand and this is a no-op.
+    void prefetch(int row_begin, int row_count) const;
+
+private:
+    struct Field {
+        std::string name;
+        int width;
+        const float32* data;
+    };
+
+    bool parse();
+
+    const uint8_t* base_;
+    size_t size_;
+    int rows_;
+    std::vector<Field> fields_;
+#ifdef ESP_PLATFORM
+    uint32_t mmap_handle_;
+#else
+    int fd_;
+#endif
+
+    MappedDataset(const MappedDataset&);
+    MappedDataset& operator=(const MappedDataset&);
+};
+
+// Walks a mapped dataset in fixed-size row chunks. Moving to a chunk
+// prefetches the one after it, so the next chunk is read while the
+// current one trains.
+class ChunkLoader {
+public:
+    // Throws std::invalid_argument when chunk_rows < 1
+    ChunkLoader(const MappedDataset& dataset, int chunk_rows);
+
+    // Advance to the next chunk; returns false after the last one.
+    bool next();
+    void rewind() { begin_ = -1; count_ = 0; }
+
+    int begin() const { return begin_; }
+    int count() const { return count_; }
+
+    // View of the current chunk for a field
+    Tensor* view(int field) const { return dataset_.view(field, begin_, count_); }
+
+private:
+    const MappedDataset& dataset_;
+    int chunk_rows_;
+    int begin_;
+    int count_;
+};
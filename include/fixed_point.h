@@ -0,0 +1,267 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "matrix.h"
+
+// Fixed-point tensors and kernels for targets without a fast FPU.
+//
+// QTensor<T, Frac> stores values as T with Frac fractional bits, named
+// after the Qm.n format (integer.fraction bits, sign not counted):
+//   Q5_10Tensor  = int16_t, 10 fractional bits (range +-32, step ~1e-3)
+//   Q11_20Tensor = int32_t, 20 fractional bits (range +-2048, step ~1e-6)
+// Products are accumulated in int64_t and rounded back once per output,
+// and every narrowing step saturates instead of wrapping. Float tensors
+// convert in and out with from_tensor()/to_tensor() so results can be
+// checked against the float path (see max_abs_error()).
+
+template <typename T, int Frac>
+class QTensor {
+public:
+    typedef T value_type;
+    typedef int64_t acc_type;
+    static const int frac_bits = Frac;
+
+    int rows, cols;
+    std::vector<T> data;   // row-major
+    std::vector<T> grad;
+
+    QTensor() : rows(0), cols(0) {}
+    QTensor(int rows, int cols) : rows(rows), cols(cols), data(rows * cols, 0), grad(rows * cols, 0) {}
+
+    T& at(int i, int j) { return data[i * cols + j]; }
+    const T& at(int i, int j) const { return data[i * cols + j]; }
+
+    static T saturate(acc_type v) {
+        const acc_type hi = std::numeric_limits<T>::max();
+        const acc_type lo = std::numeric_limits<T>::min();
+        return (T)(v > hi ? hi : (v < lo ? lo : v));
+    }
+
+    static T from_float(float f) {
+        return saturate((acc_type)std::lround((double)f * (double)((acc_type)1 << Frac)));
+    }
+
+    static float to_float(T q) {
+        return (float)q / (float)((acc_type)1 << Frac);
+    }
+
+    static QTensor from_tensor(const Tensor& t) {
+        QTensor q(t.rows, t.cols);
+        for (int i = 0; i < t.rows; i++) {
+            for (int j = 0; j < t.cols; j++) {
+                q.at(i, j) = from_float(t.data[i][j]);
+            }
+        }
+        return q;
+    }
+
+    void to_tensor(Tensor& t) const {
+        if (t.rows != rows || t.cols != cols) {
+            throw std::invalid_argument("Tensor shape does not match QTensor");
+        }
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) {
+                t.data[i][j] = to_float(at(i, j));
+            }
+        }
+    }
+
+    void zero_grad() {
+        std::fill(grad.begin(), grad.end(), (T)0);
+    }
+};
+
+typedef QTensor<int16_t, 10> Q5_10Tensor;
+typedef QTensor<int32_t, 20> Q11_20Tensor;
+
+namespace fixed {
+
+// xorshift32 source for stochastic rounding
+struct Random {
+    uint32_t state;
+    explicit Random(uint32_t seed = 0x2545F491u) : state(seed ? seed : 1) {}
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+};
+
+// Round-to-nearest shift of a wide product back to Frac bits
+template <int Shift>
+inline int64_t round_shift(int64_t v) {
+    return (v + ((int64_t)1 << (Shift - 1))) >> Shift;
+}
+
+template <typename Q>
+void check_same_shape(const Q& a, const Q& b) {
+    if (a.rows != b.rows || a.cols != b.cols) {
+        throw std::invalid_argument("Matrix dimensions do not match");
+    }
+}
+
+// out = a + b, saturating
+template <typename T, int F>
+void add(const QTensor<T, F>& a, const QTensor<T, F>& b, QTensor<T, F>& out) {
+    check_same_shape(a, b);
+    out = QTensor<T, F>(a.rows, a.cols);
+    for (size_t i = 0; i < a.data.size(); i++) {
+        out.data[i] = QTensor<T, F>::saturate((int64_t)a.data[i] + b.data[i]);
+    }
+}
+
+// out = a - b, saturating
+template <typename T, int F>
+void sub(const QTensor<T, F>& a, const QTensor<T, F>& b, QTensor<T, F>& out) {
+    check_same_shape(a, b);
+    out = QTensor<T, F>(a.rows, a.cols);
+    for (size_t i = 0; i < a.data.size(); i++) {
+        out.data[i] = QTensor<T, F>::saturate((int64_t)a.data[i] - b.data[i]);
+    }
+}
+
+// out (m x n) = a (m x k) * b (k x n), 64-bit accumulation, one rounding per output
+template <typename T, int F>
+void gemm(const QTensor<T, F>& a, const QTensor<T, F>& b, QTensor<T, F>& out) {
+    if (a.cols != b.rows) {
+        throw std::invalid_argument("Matrix dimensions do not match for multiplication");
+    }
+    out = QTensor<T, F>(a.rows, b.cols);
+    std::vector<int64_t> acc(b.cols);
+    for (int i = 0; i < a.rows; i++) {
+        std::fill(acc.begin(), acc.end(), 0);
+        for (int k = 0; k < a.cols; k++) {
+            int64_t av = a.at(i, k);
+            const T* br = &b.data[k * b.cols];
+            for (int j = 0; j < b.cols; j++) {
+                acc[j] += av * br[j];
+            }
+        }
+        for (int j = 0; j < b.cols; j++) {
+            out.at(i, j) = QTensor<T, F>::saturate(round_shift<F>(acc[j]));
+        }
+    }
+}
+
+// Backward of out = a * b using out.grad:
+//   a.grad += out.grad * b^T,  b.grad += a^T * out.grad
+template <typename T, int F>
+void gemm_backward(QTensor<T, F>& a, QTensor<T, F>& b, const QTensor<T, F>& out, bool grad_a = true) {
+    if (grad_a) {
+        for (int i = 0; i < a.rows; i++) {
+            for (int k = 0; k < a.cols; k++) {
+                int64_t acc = 0;
+                const T* br = &b.data[k * b.cols];
+                const T* gr = &out.grad[i * out.cols];
+                for (int j = 0; j < b.cols; j++) {
+                    acc += (int64_t)gr[j] * br[j];
+                }
+                T& g = a.grad[i * a.cols + k];
+                g = QTensor<T, F>::saturate((int64_t)g + round_shift<F>(acc));
+            }
+        }
+    }
+    std::vector<int64_t> acc(b.rows * b.cols, 0);
+    for (int i = 0; i < a.rows; i++) {
+        const T* gr = &out.grad[i * out.cols];
+        for (int k = 0; k < a.cols; k++) {
+            int64_t av = a.at(i, k);
+            int64_t* accr = &acc[k * b.cols];
+            for (int j = 0; j < b.cols; j++) {
+                accr[j] += av * gr[j];
+            }
+        }
+    }
+    for (size_t i = 0; i < acc.size(); i++) {
+        b.grad[i] = QTensor<T, F>::saturate((int64_t)b.grad[i] + round_shift<F>(acc[i]));
+    }
+}
+
+// LeakyReLU with the slope given as a real number, applied as a Q multiply
+template <typename T, int F>
+void leakyrelu(const QTensor<T, F>& in, QTensor<T, F>& out, float leaky = 0.01f) {
+    out = QTensor<T, F>(in.rows, in.cols);
+    int64_t slope = QTensor<T, F>::from_float(leaky);
+    for (size_t i = 0; i < in.data.size(); i++) {
+        T x = in.data[i];
+        out.data[i] = x > 0 ? x : (T)round_shift<F>(slope * x);
+    }
+}
+
+// in.grad += d leakyrelu * out.grad
+template <typename T, int F>
+void leakyrelu_backward(QTensor<T, F>& in, const QTensor<T, F>& out, float leaky = 0.01f) {
+    int64_t slope = QTensor<T, F>::from_float(leaky);
+    for (size_t i = 0; i < in.data.size(); i++) {
+        int64_t g = out.grad[i];
+        int64_t d = in.data[i] > 0 ? g : round_shift<F>(slope * g);
+        in.grad[i] = QTensor<T, F>::saturate((int64_t)in.grad[i] + d);
+    }
+}
+
+// Mean squared error; writes dL/dpred = 2 / n * (pred - target) into pred.grad
+// and returns the loss as a float for reporting.
+template <typename T, int F>
+float mse_loss(QTensor<T, F>& pred, const QTensor<T, F>& target) {
+    check_same_shape(pred, target);
+    int64_t n = (int64_t)pred.data.size();
+    int64_t sq = 0;
+    for (size_t i = 0; i < pred.data.size(); i++) {
+        int64_t diff = (int64_t)pred.data[i] - target.data[i];
+        // |diff| can reach 2^32 for 32-bit T, so square it unsigned and
+        // round the shift without the bias add that round_shift would do
+        uint64_t mag = (uint64_t)(diff < 0 ? -diff : diff);
+        uint64_t square = mag * mag;
+        uint64_t term = (square >> F) + ((square >> (F - 1)) & 1);
+        sq = term > (uint64_t)(INT64_MAX - sq) ? INT64_MAX : sq + (int64_t)term;
+        int64_t g = 2 * diff;
+        pred.grad[i] = QTensor<T, F>::saturate((g + (g >= 0 ? n / 2 : -n / 2)) / n);
+    }
+    return QTensor<T, F>::to_float(QTensor<T, F>::saturate(sq / n));
+}
+
+// Fractional bits of the learning rate in sgd_step. Independent of the
+// tensor format, so a rate far below the tensor's Q step keeps its value.
+const int LR_FRAC = 30;
+
+// p -= lr * grad with stochastic rounding: the bits below the Q step are
+// kept as a probability of rounding up, so small updates are not lost.
+// lr is taken as Q0.30 in int64 and must lie in [0, 2) so that
+// lr * grad cannot overflow.
+template <typename T, int F>
+void sgd_step(QTensor<T, F>& p, float learning_rate, Random& rng) {
+    if (!(learning_rate >= 0.0f && learning_rate < 2.0f)) {
+        throw std::invalid_argument("Fixed-point learning rate must be in [0, 2)");
+    }
+    int64_t lr = (int64_t)std::llround((double)learning_rate * (double)((int64_t)1 << LR_FRAC));
+    const int64_t mask = ((int64_t)1 << LR_FRAC) - 1;
+    for (size_t i = 0; i < p.data.size(); i++) {
+        int64_t delta = lr * p.grad[i];   // F + LR_FRAC fractional bits
+        int64_t noise = (int64_t)(rng.next() & (uint32_t)mask);
+        int64_t step = (delta + noise) >> LR_FRAC;
+        p.data[i] = QTensor<T, F>::saturate((int64_t)p.data[i] - step);
+    }
+}
+
+// Largest |q - f| over all entries, for parity checks against the float path
+template <typename T, int F>
+float max_abs_error(const QTensor<T, F>& q, const Tensor& f) {
+    if (q.rows != f.rows || q.cols != f.cols) {
+        throw std::invalid_argument("Matrix dimensions do not match");
+    }
+    float err = 0.0f;
+    for (int i = 0; i < q.rows; i++) {
+        for (int j = 0; j < q.cols; j++) {
+            float e = std::fabs(QTensor<T, F>::to_float(q.at(i, j)) - f.data[i][j]);
+            err = e > err ? e : err;
+        }
+    }
+    return err;
+}
+
+}
@@ -3,6 +3,7 @@
 #include <unordered_set>
 #include <cstring>
 #include <cmath>   
+#include <algorithm>
 const float CLIP_NORM = 1.0f;
 const float MIN_GRAD_NORM = 1e-3f;  
 const float EPSILON = 1e-6f;        
@@ -37,24 +38,178 @@ void clip_gradient(float** grad, int rows, int cols) {
     }
 }
 
+namespace {
+
+// Dense kernels over row pointers, shared by operator* and conv1d.
+// All three accumulate each element in ascending k order.
+
+// out (m x n) = A (m x k) * B (k x n)
+void gemm(float32** A, int m, int k, float32** B, int n, float32** out) {
+    for (int i = 0; i < m; i++) {
+        float32* o = out[i];
+        memset(o, 0, n * sizeof(float32));
+        for (int p = 0; p < k; p++) {
+            float32 a = A[i][p];
+            const float32* b = B[p];
+            for (int j = 0; j < n; j++) {
+                o[j] += a * b[j];
+            }
+        }
+    }
+}
+
+// dA (m x k) += G (m x n) * B^T, B is k x n
+void gemm_grad_left(float32** G, int m, int n, float32** B, int k, float32** dA) {
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < k; j++) {
+            for (int p = 0; p < n; p++) {
+                dA[i][j] += G[i][p] * B[j][p];
+            }
+        }
+    }
+}
+
+// dB (k x n) += A^T * G, A is m x k and G is m x n
+void gemm_grad_right(float32** A, int m, int k, float32** G, int n, float32** dB) {
+    for (int p = 0; p < m; p++) {
+        const float32* g = G[p];
+        for (int i = 0; i < k; i++) {
+            float32 a = A[p][i];
+            float32* d = dB[i];
+            for (int j = 0; j < n; j++) {
+                d[j] += g[j] * a;
+            }
+        }
+    }
+}
+
+// im2col and col2im buffers. Kept per thread so data-parallel workers and
+// the backward pool never share them; they grow to the largest conv seen
+// and are reused by every later call.
+struct ConvScratch {
+    std::vector<float32> cols;
+    std::vector<float32*> rows;
+    std::vector<float32> dcols;
+    std::vector<float32*> drows;
+};
+
+thread_local ConvScratch conv_scratch;
+
+// Number of output windows. A dilated kernel wider than the padded input
+// gives a negative span, which integer division would truncate to one
+// window, so it is rejected here.
+int conv_out_len(int length, const OpAttrs& a) {
+    long span = (long)length + 2L * a.padding - (long)a.dilation * (a.kernel_size - 1) - 1;
+    if (span < 0) {
+        throw std::invalid_argument("Conv1d kernel does not fit the input");
+    }
+    return (int)(span / a.stride + 1);
+}
+
+// Source row of tap k in output window t, or -1 inside the padding
+inline int conv_src(int t, int k, const OpAttrs& a, int length) {
+    int src = t * a.stride - a.padding + k * a.dilation;
+    return src >= 0 && src < length ? src : -1;
+}
+
+// Row-pointer view of an out_len x (kernel_size * width) zeroed buffer
+float32** scratch_rows(std::vector<float32>& buf, std::vector<float32*>& rows, int out_len, int width) {
+    buf.assign((size_t)out_len * width, 0.0f);
+    rows.resize(out_len);
+    for (int t = 0; t < out_len; t++) {
+        rows[t] = buf.data() + (size_t)t * width;
+    }
+    return rows.data();
+}
+
+// Row t holds the kernel_size input rows under output window t, zeros in
+// the padding
+float32** im2col(const Tensor& x, const OpAttrs& a, int out_len) {
+    int channels = x.cols;
+    float32** rows = scratch_rows(conv_scratch.cols, conv_scratch.rows, out_len, a.kernel_size * channels);
+    for (int t = 0; t < out_len; t++) {
+        for (int k = 0; k < a.kernel_size; k++) {
+            int src = conv_src(t, k, a, x.rows);
+            if (src >= 0) {
+                memcpy(rows[t] + k * channels, x.data[src], channels * sizeof(float32));
+            }
+        }
+    }
+    return rows;
+}
+
+}
+
+const char* op_symbol(OpId op) {
+    switch (op) {
+        case OpId::Add: return "+";
+        case OpId::Sub: return "-";
+        case OpId::Div: return "/";
+        case OpId::Mul: return "*";
+        case OpId::Dot: return "^";
+        case OpId::LeakyRelu: return "leakyrelu";
+        case OpId::Tanh: return "tanh";
+        case OpId::Sigmoid: return "sigmoid";
+        case OpId::Gelu: return "gelu";
+        case OpId::Silu: return "silu";
+        case OpId::Sum: return "sum";
+        case OpId::Mean: return "mean";
+        case OpId::Mse: return "mse";
+        case OpId::Checkpoint: return "checkpoint";
+        case OpId::BiasAdd: return "bias_add";
+        case OpId::Conv1d: return "conv1d";
+        default: return "";
+    }
+}
+
+std::string Tensor::label() const {
+#if NN_STRIP_NAMES
+    return op_symbol(op);
+#else
+    if (op == OpId::Leaf || !name.empty()) {
+        return name;
+    }
+    // Children are released after backward; show them as "?"
+    std::string l = left ? left->label() : "?";
+    std::string r = right ? right->label() : "?";
+    switch (op) {
+        case OpId::Add:
+        case OpId::Sub:
+        case OpId::Div:
+        case OpId::Mul:
+        case OpId::Dot:
+            return "(" + l + op_symbol(op) + r + ")";
+        case OpId::Mse:
+        case OpId::BiasAdd:
+        case OpId::Conv1d:
+            return std::string(op_symbol(op)) + "(" + l + ", " + r + ")";
+        default:
+            return std::string(op_symbol(op)) + "(" + l + ")";
+    }
+#endif
+}
+
 Tensor& Tensor::operator=(const Tensor& t) {
     if (this == &t) {
         return *this;
     }
+    if (!t.data) {
+        throw std::logic_error("Cannot assign from a tensor whose dense storage was released");
+    }
 
-    Tensor* new_tensor = new Tensor(t.rows, t.cols);
+    Tensor* new_tensor = new Tensor(t.rows, t.cols, nullptr, "", t.requires_grad);
 
     for (int j = 0; j < t.rows; j++) {
         memcpy(new_tensor->data[j], t.data[j], t.cols * sizeof(float32));
     }
 
-    new_tensor->name = t.name;
     new_tensor->_backward = t._backward;
     new_tensor->left = t.left;   
     new_tensor->right = t.right;
     
     data_holder.reset();
     grad_holder.reset();
+    track_release();
 
     this->data_holder = std::move(new_tensor->data_holder);
     this->grad_holder = std::move(new_tensor->grad_holder);
@@ -63,9 +218,22 @@ Tensor& Tensor::operator=(const Tensor& t) {
     this->grad = this->grad_holder.get();
     this->rows = new_tensor->rows;
     this->cols = new_tensor->cols;
+    this->requires_grad = t.requires_grad;
+    track_alloc(this->rows, this->cols);
     this->left = std::move(new_tensor->left);
     this->right = std::move(new_tensor->right);
-    this->name = std::move(new_tensor->name);
+#if !NN_STRIP_NAMES
+    this->name = t.name;
+#endif
+    this->op = t.op;
+    if (t.sparse) {
+        this->sparse = std::make_shared<CSRMatrix>(*t.sparse);
+    } else {
+        this->sparse.reset();
+    }
+    this->segment = t.segment;
+    this->saved = t.saved;
+    this->attrs = t.attrs;
 
     this->_backward = new_tensor->_backward;
 
@@ -79,11 +247,11 @@ Tensor& Tensor::operator=(const Tensor& t) {
 }
 
 Tensor Tensor::operator+(const Tensor &t) const {
-    Tensor result(this->rows, this->cols);
+    Tensor result(this->rows, this->cols, nullptr, "", requires_grad || t.requires_grad);
 
     result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
     result.right = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(&t));
-    result.name = this->name + "+" + t.name;
+    result.op = OpId::Add;
     for (int j = 0; j < rows; j++) {
         for (int k = 0; k < cols; k++) {
             result.data[j][k] = this->data[j][k] + t.data[j][k];
@@ -94,10 +262,10 @@ Tensor Tensor::operator+(const Tensor &t) const {
 }
 
 Tensor Tensor::operator-(const Tensor &t) const {
-    Tensor result(this->rows, this->cols);
+    Tensor result(this->rows, this->cols, nullptr, "", requires_grad || t.requires_grad);
     result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
     result.right = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(&t));
-    result.name = this->name + "-" + t.name;
+    result.op = OpId::Sub;
 
     for (int j = 0; j < rows; j++) {
         for (int k = 0; k < cols; k++) {
@@ -109,7 +277,7 @@ Tensor Tensor::operator-(const Tensor &t) const {
 }
 
 void Tensor::backsub(){
-    if(this->left){
+    if(this->left && left->requires_grad){
         for(int i = 0;i<this->rows;i++){
             for(int j = 0;j<this->cols;j++){
                 left->grad[i][j] = left->grad[i][j] + this->grad[i][j];
@@ -117,7 +285,7 @@ void Tensor::backsub(){
         }
         clip_gradient(left->grad,this->left->rows, this->left->cols);
     }
-    if(this->right){
+    if(this->right && right->requires_grad){
         for(int i = 0;i<this->rows;i++){
             for(int j = 0;j<this->cols;j++){
                 right->grad[i][j] = right->grad[i][j] - this->grad[i][j];
@@ -128,7 +296,7 @@ void Tensor::backsub(){
 }
 
 void Tensor::backadd() {
-    if (this->left) {
+    if (this->left && left->requires_grad) {
         for (int i = 0; i < this->rows; i++) {
             for (int j = 0; j < this->cols; j++) {
                 left->grad[i][j] = left->grad[i][j] + this->grad[i][j];
@@ -136,7 +304,7 @@ void Tensor::backadd() {
         }
         clip_gradient(left->grad,this->left->rows, this->left->cols);
     }
-    if (this->right) {
+    if (this->right && right->requires_grad) {
         for (int i = 0; i < this->rows; i++) {
             for (int j = 0; j < this->cols; j++) {
                 right->grad[i][j] = right->grad[i][j] + this->grad[i][j];
@@ -147,10 +315,10 @@ void Tensor::backadd() {
 }
 
 Tensor Tensor::operator/(const Tensor &t) const {
-    Tensor result(this->rows, this->cols);
+    Tensor result(this->rows, this->cols, nullptr, "", requires_grad || t.requires_grad);
     result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
     result.right = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(&t));
-    result.name = this->name + "/" + t.name;
+    result.op = OpId::Div;
 
     for (int j = 0; j < rows; j++) {
         for (int k = 0; k < cols; k++) {
@@ -165,19 +333,20 @@ Tensor Tensor::operator*(const Tensor &t) const {
         throw std::invalid_argument("Matrix dimensions do not match for multiplication");
     }
 
-    Tensor result(this->rows, t.cols);
+    Tensor result(this->rows, t.cols, nullptr, "", requires_grad || t.requires_grad);
     result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
     result.right = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(&t));
-    result.name = this->name + "*" + t.name;
+    result.op = OpId::Mul;
     result._backward = &Tensor::backmul;
-    for (int i = 0; i < this->rows; i++) {
-        for (int j = 0; j < t.cols; j++) {
-            result.data[i][j] = 0;
-            for (int k = 0; k < this->cols; k++) {
-                result.data[i][j] += this->data[i][k] * t.data[k][j];
-            }
-        }
+    if (t.sparse) {
+        spmm_dense_csr(this->data, this->rows, this->cols, *t.sparse, result.data);
+        return result;
     }
+    if (this->sparse) {
+        spmm_csr_dense(*this->sparse, t.data, t.cols, result.data);
+        return result;
+    }
+    gemm(this->data, this->rows, this->cols, t.data, t.cols, result.data);
     return result;
 }
 
@@ -189,26 +358,43 @@ void Tensor::backmul(){
     // dL/dA (3x2)
     // dL/dB = dL/dA * C^T
     // dL/dC = B^T * dL/dA
-    if(this->left){
-        for(int i = 0; i<this->rows;i++){
-            for(int j = 0;j<this->right->rows;j++){
-                for(int k = 0;k<this->cols;k++){
-                    left->grad[i][j] += this->grad[i][k] * right->data[j][k];
-                }
-            }
-        }
-        clip_gradient(left->grad,this->left->rows, this->left->cols);
+    backmul_left();
+    backmul_right();
+}
+
+// dL/dB = dL/dA * C^T. Touches only left->grad, so it can run
+// concurrently with backmul_right.
+void Tensor::backmul_left(){
+    if(!this->left || !left->requires_grad){
+        return;
     }
-    if(this->right){
-        for(int i = 0;i<this->left->cols;i++){
-            for(int j = 0;j<this->cols;j++){
-                for(int k = 0;k<this->rows;k++){
-                    right->grad[i][j] += this->grad[k][j] * left->data[k][i];
-                }
-            }
-        }
-        clip_gradient(right->grad, this->right->rows, this->right->cols);
+    if (this->right->sparse) {
+        spmm_dense_csr_backward(left->data, left->rows, left->cols, *right->sparse,
+                                this->grad, left->grad, nullptr);
+    } else if (this->left->sparse) {
+        spmm_csr_dense_backward(*left->sparse, right->data, right->cols,
+                                this->grad, left->grad, nullptr);
+    } else {
+        gemm_grad_left(this->grad, this->rows, this->cols, right->data, right->rows, left->grad);
+    }
+    clip_gradient(left->grad,this->left->rows, this->left->cols);
+}
+
+// dL/dC = B^T * dL/dA. Touches only right->grad.
+void Tensor::backmul_right(){
+    if(!this->right || !right->requires_grad){
+        return;
+    }
+    if (this->right->sparse) {
+        spmm_dense_csr_backward(left->data, left->rows, left->cols, *right->sparse,
+                                this->grad, nullptr, right->grad);
+    } else if (this->left->sparse) {
+        spmm_csr_dense_backward(*left->sparse, right->data, right->cols,
+                                this->grad, nullptr, right->grad);
+    } else {
+        gemm_grad_right(left->data, left->rows, left->cols, this->grad, this->cols, right->grad);
     }
+    clip_gradient(right->grad, this->right->rows, this->right->cols);
 }
 
 Tensor Tensor::operator^(const Tensor &t) const {
@@ -216,10 +402,10 @@ Tensor Tensor::operator^(const Tensor &t) const {
         throw std::invalid_argument("Matrix dimensions do not match for dot multiplication");
     }
 
-    Tensor result(t.cols, t.cols);
+    Tensor result(t.cols, t.cols, nullptr, "", requires_grad || t.requires_grad);
     result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
     result.right = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(&t));
-    result.name = this->name + "^" + t.name;
+    result.op = OpId::Dot;
 
     for (int i = 0;i<this->rows;i++){
         result.data[0][0] += this->data[i][0] * t.data[i][0];
@@ -229,13 +415,13 @@ Tensor Tensor::operator^(const Tensor &t) const {
 }
 
 void Tensor::backdot(){
-    if(this->left){
+    if(this->left && left->requires_grad){
         for(int i = 0;i<this->left->rows;i++){
             left->grad[i][0] += ((this->grad[0][0] * right->data[i][0]));
         }
         clip_gradient(left->grad,this->left->rows, this->left->cols);
     }
-    if(this->right){
+    if(this->right && right->requires_grad){
         for(int i = 0;i<this->right->rows;i++){
             right->grad[i][0] += (this->grad[0][0] * left->data[i][0]);
         }
@@ -244,9 +430,10 @@ void Tensor::backdot(){
 }
 
 Tensor Tensor::lekyrelu(float leaky){
-    Tensor result(this->rows, this->cols);
+    Tensor result(this->rows, this->cols, nullptr, "", requires_grad);
     result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
-    result.name = this->name + "leakyrelu";
+    result.op = OpId::LeakyRelu;
+    result.attrs.alpha = leaky;
     for (int i = 0; i < this->rows; i++) {
         for (int j = 0; j < this->cols; j++) {
             result.data[i][j] = this->data[i][j] > 0 ? this->data[i][j] : leaky * this->data[i][j];
@@ -257,10 +444,10 @@ Tensor Tensor::lekyrelu(float leaky){
 }
 
 void Tensor::backleakyrelu() {
-    if (this->left) {
+    if (this->left && left->requires_grad) {
         for (int i = 0; i < this->rows; i++) {
             for (int j = 0; j < this->cols; j++) {
-                left->grad[i][j] += (this->data[i][j]) > 0 ? this->grad[i][j] : 0.01 * this->grad[i][j];
+                left->grad[i][j] += (this->data[i][j]) > 0 ? this->grad[i][j] : attrs.alpha * this->grad[i][j];
             }
         }
         clip_gradient(left->grad,this->left->rows, this->left->cols);
@@ -268,6 +455,364 @@ void Tensor::backleakyrelu() {
 }
 
 
+Tensor Tensor::tanh(Approx approx) const {
+    Tensor result(this->rows, this->cols, nullptr, "", requires_grad);
+    result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
+    result.op = OpId::Tanh;
+    result.attrs.approx = approx;
+    for (int i = 0; i < this->rows; i++) {
+        activation::tanh_row(this->data[i], result.data[i], this->cols, approx);
+    }
+    result._backward = &Tensor::backtanh;
+    return result;
+}
+
+void Tensor::backtanh() {
+    // d tanh(x) = 1 - y^2, using the stored output
+    if (this->left && left->requires_grad) {
+        for (int i = 0; i < this->rows; i++) {
+            for (int j = 0; j < this->cols; j++) {
+                float32 y = this->data[i][j];
+                left->grad[i][j] += (1.0f - y * y) * this->grad[i][j];
+            }
+        }
+        clip_gradient(left->grad,this->left->rows, this->left->cols);
+    }
+}
+
+Tensor Tensor::sigmoid(Approx approx) const {
+    Tensor result(this->rows, this->cols, nullptr, "", requires_grad);
+    result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
+    result.op = OpId::Sigmoid;
+    result.attrs.approx = approx;
+    for (int i = 0; i < this->rows; i++) {
+        activation::sigmoid_row(this->data[i], result.data[i], this->cols, approx);
+    }
+    result._backward = &Tensor::backsigmoid;
+    return result;
+}
+
+void Tensor::backsigmoid() {
+    // d sigmoid(x) = y * (1 - y), using the stored output
+    if (this->left && left->requires_grad) {
+        for (int i = 0; i < this->rows; i++) {
+            for (int j = 0; j < this->cols; j++) {
+                float32 y = this->data[i][j];
+                left->grad[i][j] += y * (1.0f - y) * this->grad[i][j];
+            }
+        }
+        clip_gradient(left->grad,this->left->rows, this->left->cols);
+    }
+}
+
+Tensor Tensor::gelu(Approx approx) const {
+    Tensor result(this->rows, this->cols, nullptr, "", requires_grad);
+    result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
+    result.op = OpId::Gelu;
+    result.attrs.approx = approx;
+    for (int i = 0; i < this->rows; i++) {
+        activation::gelu_row(this->data[i], result.data[i], this->cols, approx);
+    }
+    result._backward = &Tensor::backgelu;
+    return result;
+}
+
+void Tensor::backgelu() {
+    // u = c * (x + k * x^3), t = tanh(u)
+    // d gelu(x) = 0.5 * (1 + t) + 0.5 * x * (1 - t^2) * c * (1 + 3 * k * x^2)
+    if (this->left && left->requires_grad) {
+        for (int i = 0; i < this->rows; i++) {
+            for (int j = 0; j < this->cols; j++) {
+                float32 x = left->data[i][j];
+                float32 x2 = x * x;
+                float32 t = activation::tanh_approx(activation::GELU_C * (x + activation::GELU_K * x2 * x), attrs.approx);
+                float32 du = activation::GELU_C * (1.0f + 3.0f * activation::GELU_K * x2);
+                float32 d = 0.5f * (1.0f + t) + 0.5f * x * (1.0f - t * t) * du;
+                left->grad[i][j] += d * this->grad[i][j];
+            }
+        }
+        clip_gradient(left->grad,this->left->rows, this->left->cols);
+    }
+}
+
+Tensor Tensor::silu(Approx approx) const {
+    Tensor result(this->rows, this->cols, nullptr, "", requires_grad);
+    result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
+    result.op = OpId::Silu;
+    result.attrs.approx = approx;
+    for (int i = 0; i < this->rows; i++) {
+        activation::silu_row(this->data[i], result.data[i], this->cols, approx);
+    }
+    result._backward = &Tensor::backsilu;
+    return result;
+}
+
+void Tensor::backsilu() {
+    // d silu(x) = s + x * s * (1 - s), s = sigmoid(x)
+    if (this->left && left->requires_grad) {
+        for (int i = 0; i < this->rows; i++) {
+            for (int j = 0; j < this->cols; j++) {
+                float32 x = left->data[i][j];
+                float32 sg = activation::sigmoid_approx(x, attrs.approx);
+                left->grad[i][j] += (sg + x * sg * (1.0f - sg)) * this->grad[i][j];
+            }
+        }
+        clip_gradient(left->grad,this->left->rows, this->left->cols);
+    }
+}
+
+Tensor Tensor::sum() const {
+    Tensor result(1, 1, nullptr, "", requires_grad);
+    result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
+    result.op = OpId::Sum;
+    float32 acc = 0.0f;
+    for (int i = 0; i < this->rows; i++) {
+        for (int j = 0; j < this->cols; j++) {
+            acc += this->data[i][j];
+        }
+    }
+    result.data[0][0] = acc;
+    result._backward = &Tensor::backsum;
+    return result;
+}
+
+void Tensor::backsum() {
+    if (this->left && left->requires_grad) {
+        float32 g = this->grad[0][0];
+        for (int i = 0; i < left->rows; i++) {
+            for (int j = 0; j < left->cols; j++) {
+                left->grad[i][j] += g;
+            }
+        }
+        clip_gradient(left->grad,this->left->rows, this->left->cols);
+    }
+}
+
+Tensor Tensor::mean() const {
+    Tensor result = this->sum();
+    result.op = OpId::Mean;
+    result.data[0][0] /= static_cast<float32>(this->rows * this->cols);
+    result._backward = &Tensor::backmean;
+    return result;
+}
+
+void Tensor::backmean() {
+    if (this->left && left->requires_grad) {
+        float32 g = this->grad[0][0] / static_cast<float32>(left->rows * left->cols);
+        for (int i = 0; i < left->rows; i++) {
+            for (int j = 0; j < left->cols; j++) {
+                left->grad[i][j] += g;
+            }
+        }
+        clip_gradient(left->grad,this->left->rows, this->left->cols);
+    }
+}
+
+// Mean squared error as a graph node. The same pass that sums the loss
+// stores dL/dpred, so backward only scales it by the upstream grad.
+Tensor Tensor::mse_loss(const Tensor &target) const {
+    if (this->rows != target.rows || this->cols != target.cols) {
+        throw std::invalid_argument("Matrix dimensions do not match for mse loss");
+    }
+
+    Tensor result(1, 1, nullptr, "", requires_grad || target.requires_grad);
+    result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
+    result.right = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(&target));
+    result.op = OpId::Mse;
+
+    float32 inv_n = 1.0f / static_cast<float32>(this->rows * this->cols);
+    float32* dpred = nullptr;
+    if (this->requires_grad) {
+        result.saved = std::make_shared<std::vector<float32>>((size_t)this->rows * this->cols);
+        dpred = result.saved->data();
+    }
+    float32 acc = 0.0f;
+    for (int i = 0; i < this->rows; i++) {
+        for (int j = 0; j < this->cols; j++) {
+            float32 diff = this->data[i][j] - target.data[i][j];
+            acc += diff * diff;
+            if (dpred) {
+                *dpred++ = 2.0f * inv_n * diff;
+            }
+        }
+    }
+    result.data[0][0] = acc * inv_n;
+    result._backward = &Tensor::backmse;
+    return result;
+}
+
+void Tensor::backmse() {
+    // dL/dpred = 2 / n * (pred - target), saved by the forward pass; the
+    // target never receives gradient
+    if (this->left && left->requires_grad) {
+        float32 g = this->grad[0][0];
+        const float32* dpred = saved->data();
+        for (int i = 0; i < left->rows; i++) {
+            for (int j = 0; j < left->cols; j++) {
+                left->grad[i][j] += g * *dpred++;
+            }
+        }
+        clip_gradient(left->grad,this->left->rows, this->left->cols);
+    }
+}
+
+
+// Runs fn on a detached copy of this tensor and keeps only the segment's
+// output. Everything fn allocated in between is released on return and
+// rebuilt by backcheckpoint, trading one extra forward for the memory.
+Tensor Tensor::checkpoint(const std::shared_ptr<Segment>& fn) const {
+    minimal::intrusive_ptr<Tensor> in(new Tensor(this->rows, this->cols, this->data, "", this->requires_grad));
+    minimal::intrusive_ptr<Tensor> out = (*fn)(in);
+
+    Tensor result(out->rows, out->cols, out->data, "", out->requires_grad);
+    result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
+    result.op = OpId::Checkpoint;
+    result.segment = fn;
+    result._backward = &Tensor::backcheckpoint;
+    return result;
+}
+
+void Tensor::backcheckpoint() {
+    if (!this->left || !this->segment) {
+        return;
+    }
+    // Recompute the dropped activations, then backprop through them
+    minimal::intrusive_ptr<Tensor> in(new Tensor(left->rows, left->cols, left->data, "", left->requires_grad));
+    minimal::intrusive_ptr<Tensor> out = (*segment)(in);
+    for (int i = 0; i < this->rows; i++) {
+        memcpy(out->grad[i], this->grad[i], this->cols * sizeof(float32));
+    }
+    out->backprop();
+
+    if (left->requires_grad) {
+        for (int i = 0; i < left->rows; i++) {
+            for (int j = 0; j < left->cols; j++) {
+                left->grad[i][j] += in->grad[i][j];
+            }
+        }
+        clip_gradient(left->grad,this->left->rows, this->left->cols);
+    }
+    this->segment.reset();
+}
+
+Tensor Tensor::add_bias(const Tensor &bias) const {
+    if (bias.rows != 1 || bias.cols != this->cols) {
+        throw std::invalid_argument("Bias must be 1 x cols");
+    }
+
+    Tensor result(this->rows, this->cols, nullptr, "", requires_grad || bias.requires_grad);
+    result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
+    result.right = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(&bias));
+    result.op = OpId::BiasAdd;
+    const float32* b = bias.data[0];
+    for (int i = 0; i < this->rows; i++) {
+        for (int j = 0; j < this->cols; j++) {
+            result.data[i][j] = this->data[i][j] + b[j];
+        }
+    }
+    result._backward = &Tensor::backbias;
+    return result;
+}
+
+void Tensor::backbias() {
+    if (this->left && left->requires_grad) {
+        for (int i = 0; i < this->rows; i++) {
+            for (int j = 0; j < this->cols; j++) {
+                left->grad[i][j] += this->grad[i][j];
+            }
+        }
+        clip_gradient(left->grad,this->left->rows, this->left->cols);
+    }
+    if (this->right && right->requires_grad) {
+        // Every row used the same bias, so its gradient is the column sum
+        float32* g = right->grad[0];
+        for (int i = 0; i < this->rows; i++) {
+            for (int j = 0; j < this->cols; j++) {
+                g[j] += this->grad[i][j];
+            }
+        }
+        clip_gradient(right->grad, this->right->rows, this->right->cols);
+    }
+}
+
+Tensor Tensor::conv1d(const Tensor &kernel, int stride, int padding, int dilation) const {
+    if (stride < 1 || dilation < 1 || padding < 0) {
+        throw std::invalid_argument("Invalid conv1d stride, padding or dilation");
+    }
+    if (kernel.rows % this->cols != 0) {
+        throw std::invalid_argument("Conv1d kernel rows must be a multiple of input channels");
+    }
+    OpAttrs a;
+    a.stride = stride;
+    a.padding = padding;
+    a.dilation = dilation;
+    a.kernel_size = kernel.rows / this->cols;
+    if (a.kernel_size < 1) {
+        throw std::invalid_argument("Conv1d kernel is empty");
+    }
+    int out_len = conv_out_len(this->rows, a);
+
+    Tensor result(out_len, kernel.cols, nullptr, "", requires_grad || kernel.requires_grad);
+    result.left = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(this));
+    result.right = minimal::intrusive_ptr<Tensor>(const_cast<Tensor*>(&kernel));
+    result.op = OpId::Conv1d;
+    result.attrs = a;
+
+    float32** cols = im2col(*this, a, out_len);
+    if (kernel.sparse) {
+        spmm_dense_csr(cols, out_len, kernel.rows, *kernel.sparse, result.data);
+    } else {
+        gemm(cols, out_len, kernel.rows, kernel.data, kernel.cols, result.data);
+    }
+    result._backward = &Tensor::backconv1d;
+    return result;
+}
+
+void Tensor::backconv1d() {
+    bool need_input = this->left && left->requires_grad;
+    bool need_kernel = this->right && right->requires_grad;
+    if (!need_input && !need_kernel) {
+        return;
+    }
+    int width = right->rows;
+
+    if (need_kernel) {
+        // dK = cols^T * G, with the windows rebuilt instead of kept from forward
+        float32** cols = im2col(*left, attrs, this->rows);
+        if (right->sparse) {
+            spmm_dense_csr_backward(cols, this->rows, width, *right->sparse, this->grad, nullptr, right->grad);
+        } else {
+            gemm_grad_right(cols, this->rows, width, this->grad, this->cols, right->grad);
+        }
+        clip_gradient(right->grad, this->right->rows, this->right->cols);
+    }
+
+    if (need_input) {
+        // dcols = G * K^T, then col2im adds each window back onto its input rows
+        float32** dcols = scratch_rows(conv_scratch.dcols, conv_scratch.drows, this->rows, width);
+        if (right->sparse) {
+            spmm_dense_csr_backward(nullptr, this->rows, width, *right->sparse, this->grad, dcols, nullptr);
+        } else {
+            gemm_grad_left(this->grad, this->rows, this->cols, right->data, width, dcols);
+        }
+        int channels = left->cols;
+        for (int t = 0; t < this->rows; t++) {
+            for (int k = 0; k < attrs.kernel_size; k++) {
+                int src = conv_src(t, k, attrs, left->rows);
+                if (src < 0) {
+                    continue;
+                }
+                const float32* d = dcols[t] + k * channels;
+                float32* g = left->grad[src];
+                for (int c = 0; c < channels; c++) {
+                    g[c] += d[c];
+                }
+            }
+        }
+        clip_gradient(left->grad,this->left->rows, this->left->cols);
+    }
+}
+
 void visit_tensor(const minimal::intrusive_ptr<Tensor>& t,
                  std::set<minimal::intrusive_ptr<Tensor>>& visited,
                  std::vector<minimal::intrusive_ptr<Tensor>>& topo) {
@@ -292,6 +837,14 @@ void visit_tensor(const minimal::intrusive_ptr<Tensor>& t,
 }
 
 void Tensor::backward() {
+    // A 1x1 root is a loss: dL/dL = 1
+    if (rows == 1 && cols == 1 && grad) {
+        grad[0][0] = 1.0f;
+    }
+    backprop();
+}
+
+void Tensor::backprop() {
     std::vector<minimal::intrusive_ptr<Tensor>> topo;
     std::set<minimal::intrusive_ptr<Tensor>> visited;
     
@@ -299,7 +852,7 @@ void Tensor::backward() {
     visit_tensor(self, visited, topo);
 
     for (int i = topo.size() - 1; i >= 0; i--) {
-        if (topo[i]->_backward) {
+        if (topo[i]->_backward && topo[i]->requires_grad) {
             (topo[i].get()->*(topo[i]->_backward))();
         }
         // Free left and right child tensors after computation
@@ -307,8 +860,102 @@ void Tensor::backward() {
     for(int i = 0;i<topo.size();i++){
         topo[i]->left = nullptr;
         topo[i]->right = nullptr;
+        topo[i]->saved.reset();
         topo[i]->_backward = nullptr;
     }
 }
 
+void Tensor::prune(float sparsity) {
+    if (!data) {
+        throw std::logic_error("Dense storage was released; densify() before pruning again");
+    }
+    if (sparsity < 0.0f || sparsity >= 1.0f) {
+        throw std::invalid_argument("Sparsity must be in [0, 1)");
+    }
+    int n = rows * cols;
+    std::vector<float32> mags;
+    mags.reserve(n);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            mags.push_back(std::fabs(data[i][j]));
+        }
+    }
+    int cut = (int)(sparsity * n);
+    float32 threshold = 0.0f;
+    if (cut > 0) {
+        std::nth_element(mags.begin(), mags.begin() + (cut - 1), mags.end());
+        threshold = mags[cut - 1];
+    }
+    prune_threshold(threshold);
+}
 
+void Tensor::prune_threshold(float threshold) {
+    if (!data) {
+        throw std::logic_error("Dense storage was released; densify() before pruning again");
+    }
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            if (std::fabs(data[i][j]) <= threshold) {
+                data[i][j] = 0.0f;
+                if (grad) {
+                    grad[i][j] = 0.0f;
+                }
+            }
+        }
+    }
+    sparse = std::make_shared<CSRMatrix>(CSRMatrix::from_dense(data, rows, cols));
+}
+
+void Tensor::release_dense() {
+    if (!sparse) {
+        throw std::logic_error("Only a pruned tensor can release its dense storage");
+    }
+    release_storage();
+    requires_grad = false;
+    // The CSR arrays are now the tensor's value storage
+    mem_data_ = (long)sparse->bytes();
+    mem_nodes_ = (long)sizeof(Tensor);
+    telemetry::add_bytes(MEM_DATA, mem_data_);
+    telemetry::add_bytes(MEM_NODES, mem_nodes_);
+}
+
+void Tensor::densify() {
+    if (!data && sparse) {
+        Tensor dense(rows, cols, nullptr, "", true);
+        for (int i = 0; i < rows; i++) {
+            for (int p = sparse->row_ptr[i]; p < sparse->row_ptr[i + 1]; p++) {
+                dense.data[i][sparse->col_idx[p]] = sparse->values[p];
+            }
+        }
+        // Take over the buffers and the bytes charged for them
+        track_release();
+        data_holder = std::move(dense.data_holder);
+        grad_holder = std::move(dense.grad_holder);
+        data = data_holder.get();
+        grad = grad_holder.get();
+        requires_grad = true;
+        mem_data_ = dense.mem_data_;
+        mem_grad_ = dense.mem_grad_;
+        mem_nodes_ = dense.mem_nodes_;
+        dense.mem_data_ = dense.mem_grad_ = dense.mem_nodes_ = 0;
+        dense.data = dense.grad = nullptr;
+    }
+    sparse.reset();
+}
+
+std::string tensor_leak_report() {
+#if NN_TELEMETRY && defined(NN_TRACK_LEAKS)
+    telemetry::State& s = telemetry::state();
+    std::lock_guard<std::mutex> guard(s.lock);
+    std::string report;
+    for (std::set<const Tensor*>::const_iterator it = s.live.begin(); it != s.live.end(); ++it) {
+        const Tensor* t = *it;
+        std::string label = t->label();
+        report += (label.empty() ? std::string("<unnamed>") : label)
+                + " " + std::to_string(t->rows) + "x" + std::to_string(t->cols) + "\n";
+    }
+    return report;
+#else
+    return "leak tracking disabled (build with -DNN_TRACK_LEAKS)\n";
+#endif
+}
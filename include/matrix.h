@@ -8,9 +8,55 @@
 #include <functional>
 #include <memory>
 #include "minimal_intrusive_ptr.hpp"
+#include "sparse.h"
+#include "activation.h"
+#include "telemetry.h"
 
 typedef float float32;
 
+// Tensors carry a name for leaves only; op results are identified by
+// their OpId and get a readable label() on demand. Build with
+// -DNN_STRIP_NAMES=1 to compile the names out for production builds.
+#ifndef NN_STRIP_NAMES
+#define NN_STRIP_NAMES 0
+#endif
+
+// Interned op identity of a graph node
+enum class OpId : uint8_t {
+    Leaf = 0,
+    Add,
+    Sub,
+    Div,
+    Mul,
+    Dot,
+    LeakyRelu,
+    Tanh,
+    Sigmoid,
+    Gelu,
+    Silu,
+    Sum,
+    Mean,
+    Mse,
+    Checkpoint,
+    BiasAdd,
+    Conv1d
+};
+
+// Operator or function name of an op, e.g. "*" or "tanh"
+const char* op_symbol(OpId op);
+
+// Per-op scalar arguments needed again by the backward pass
+struct OpAttrs {
+    float alpha;     // LeakyReLU negative slope
+    Approx approx;   // accuracy tier of smooth activations
+    int stride;      // Conv1d window geometry
+    int padding;
+    int dilation;
+    int kernel_size;
+
+    OpAttrs() : alpha(0.01f), approx(Approx::Exact), stride(1), padding(0), dilation(1), kernel_size(1) {}
+};
+
 class Tensor : public minimal::intrusive_ref_counter<Tensor> {
     typedef float float32;
 public:
@@ -20,12 +66,98 @@ public:
     minimal::intrusive_ptr<Tensor> right;
     float32** data;  
     float32** grad;  
+    // False for inputs, targets and anything computed only from them:
+    // such tensors get no grad buffer (grad == nullptr) and backward
+    // skips the products that would feed them.
+    bool requires_grad = true;
     void (Tensor::*_backward)() = nullptr; 
+    OpId op = OpId::Leaf;
+#if !NN_STRIP_NAMES
     std::string name;
+#endif
+    // Set once the tensor is pruned; holds the surviving weights in CSR form
+    std::shared_ptr<CSRMatrix> sparse;
+    // Checkpointed segment: recomputed during backward instead of kept alive
+    typedef std::function<minimal::intrusive_ptr<Tensor>(const minimal::intrusive_ptr<Tensor>&)> Segment;
+    std::shared_ptr<Segment> segment;
+    // Row-major values the forward pass leaves for backward (mse_loss: dL/dpred)
+    std::shared_ptr<std::vector<float32>> saved;
+    OpAttrs attrs;
     // std::string uuidstr;
 private:
     std::shared_ptr<float32*[]> data_holder;  
     std::shared_ptr<float32*[]> grad_holder;  
+    // Bytes this tensor has charged to telemetry
+    long mem_data_ = 0;
+    long mem_grad_ = 0;
+    long mem_nodes_ = 0;
+
+    void track_alloc(int r, int c) {
+        mem_data_ = (long)r * c * sizeof(float32);
+        mem_grad_ = requires_grad ? (long)r * c * sizeof(float32) : 0;
+        mem_nodes_ = (long)sizeof(Tensor) + (requires_grad ? 2L : 1L) * r * sizeof(float32*);
+        telemetry::add_bytes(MEM_DATA, mem_data_);
+        telemetry::add_bytes(MEM_GRAD, mem_grad_);
+        telemetry::add_bytes(MEM_NODES, mem_nodes_);
+    }
+
+    // Zeroed grad rows, or none at all when the tensor needs no gradient
+    void alloc_grad(int r, int c) {
+        if (!requires_grad) {
+            grad_holder.reset();
+            grad = nullptr;
+            return;
+        }
+        grad_holder = std::shared_ptr<float32*[]>(new float32*[r],
+            [r](float32** p) {
+                for (int i = 0; i < r; i++) {
+                    delete[] p[i];
+                }
+                delete[] p;
+            });
+        grad = grad_holder.get();
+        for (int j = 0; j < r; j++) {
+            grad[j] = new float32[c]();
+        }
+    }
+
+    // Tensor whose data row pointers are filled in by the caller
+    static Tensor* view_shell(int rows, int cols, const std::string& name, bool requires_grad) {
+        Tensor* t = new Tensor();
+        t->release_storage();
+        t->rows = rows;
+        t->cols = cols;
+        t->set_name(name);
+        t->requires_grad = requires_grad;
+
+        t->data_holder = std::shared_ptr<float32*[]>(new float32*[rows],
+            [](float32** p) {
+                delete[] p;
+            });
+        t->data = t->data_holder.get();
+        t->alloc_grad(rows, cols);
+
+        t->mem_grad_ = requires_grad ? (long)rows * cols * sizeof(float32) : 0;
+        t->mem_nodes_ = (long)sizeof(Tensor) + (requires_grad ? 2L : 1L) * rows * sizeof(float32*);
+        telemetry::add_bytes(MEM_GRAD, t->mem_grad_);
+        telemetry::add_bytes(MEM_NODES, t->mem_nodes_);
+        return t;
+    }
+
+    void release_storage() {
+        data_holder.reset();
+        grad_holder.reset();
+        data = nullptr;
+        grad = nullptr;
+        track_release();
+    }
+
+    void track_release() {
+        telemetry::add_bytes(MEM_DATA, -mem_data_);
+        telemetry::add_bytes(MEM_GRAD, -mem_grad_);
+        telemetry::add_bytes(MEM_NODES, -mem_nodes_);
+        mem_data_ = mem_grad_ = mem_nodes_ = 0;
+    }
 
 public:
     Tensor() {
@@ -36,7 +168,7 @@ public:
         
         this->rows = 1;
         this->cols = 1;
-        this->name = "default";
+        this->set_name("default");
         this->_backward = nullptr;
         this->left = nullptr;
         this->right = nullptr;
@@ -58,9 +190,11 @@ public:
 
         data[0] = new float32[1]();  
         grad[0] = new float32[1]();  
+        telemetry::on_create(this);
+        track_alloc(1, 1);
     }
 
-    Tensor(int rows, int cols, float32** input_data = nullptr, std::string name = "") {
+    Tensor(int rows, int cols, float32** input_data = nullptr, std::string name = "", bool requires_grad = true) {
         // uuid_generate(id);
         // char uuid_str[37];
         // uuid_unparse(id, uuid_str);
@@ -68,7 +202,8 @@ public:
         
         this->rows = rows;
         this->cols = cols;
-        this->name = name;
+        this->set_name(name);
+        this->requires_grad = requires_grad;
         this->_backward = nullptr;
         this->left = nullptr;
         this->right = nullptr;
@@ -81,25 +216,41 @@ public:
                 }
                 delete[] p;
             });
-        
-        grad_holder = std::shared_ptr<float32*[]>(new float32*[r],
-            [r](float32** p) {
-                for (int i = 0; i < r; i++) {
-                    delete[] p[i];
-                }
-                delete[] p;
-            });
 
         data = data_holder.get();
-        grad = grad_holder.get();
+        alloc_grad(rows, cols);
 
         for (int j = 0; j < rows; j++) {
             data[j] = new float32[cols]();  
-            grad[j] = new float32[cols](); 
             if (input_data) {
                 memcpy(data[j], input_data[j], cols * sizeof(float32));
             }
         }
+        telemetry::on_create(this);
+        track_alloc(rows, cols);
+    }
+
+    // Non-owning view: row j aliases base + j * stride. The caller keeps the
+    // storage alive for the lifetime of the view; only grad, if required, is allocated.
+    static Tensor* view(int rows, int cols, float32* base, int stride, std::string name = "",
+                        bool requires_grad = true) {
+        Tensor* t = view_shell(rows, cols, name, requires_grad);
+        for (int j = 0; j < rows; j++) {
+            t->data[j] = base + (size_t)j * stride;
+        }
+        return t;
+    }
+
+    // Non-owning view of rows [row_begin, row_begin + row_count) of src
+    static Tensor* slice_rows(const Tensor& src, int row_begin, int row_count) {
+        if (row_begin < 0 || row_count < 0 || row_begin + row_count > src.rows) {
+            throw std::invalid_argument("Row slice out of range");
+        }
+        Tensor* t = view_shell(row_count, src.cols, src.label(), src.requires_grad);
+        for (int j = 0; j < row_count; j++) {
+            t->data[j] = src.data[row_begin + j];
+        }
+        return t;
     }
 
     // Copy constructor
@@ -111,12 +262,35 @@ public:
         
         this->rows = t.rows;
         this->cols = t.cols;
+#if !NN_STRIP_NAMES
         this->name = t.name;
+#endif
+        this->op = t.op;
+        this->requires_grad = t.requires_grad;
         this->_backward = t._backward;
         
         // Copy child pointers
         this->left = t.left;
         this->right = t.right;
+        if (t.sparse) {
+            this->sparse = std::make_shared<CSRMatrix>(*t.sparse);
+        }
+        this->segment = t.segment;
+        this->saved = t.saved;
+        this->attrs = t.attrs;
+
+        if (!t.data) {
+            // CSR-only source (see release_dense): nothing dense to copy,
+            // but the copied CSR arrays are this tensor's value storage
+            data = nullptr;
+            grad = nullptr;
+            telemetry::on_create(this);
+            mem_data_ = (long)sparse->bytes();
+            mem_nodes_ = (long)sizeof(Tensor);
+            telemetry::add_bytes(MEM_DATA, mem_data_);
+            telemetry::add_bytes(MEM_NODES, mem_nodes_);
+            return;
+        }
 
         int r = rows;
         data_holder = std::shared_ptr<float32*[]>(new float32*[r],
@@ -126,28 +300,21 @@ public:
                 }
                 delete[] p;
             });
-        
-        grad_holder = std::shared_ptr<float32*[]>(new float32*[r],
-            [r](float32** p) {
-                for (int i = 0; i < r; i++) {
-                    delete[] p[i];
-                }
-                delete[] p;
-            });
 
         data = data_holder.get();
-        grad = grad_holder.get();
+        alloc_grad(rows, cols);
 
         for (int j = 0; j < rows; j++) {
             data[j] = new float32[cols];
-            grad[j] = new float32[cols];
             if (t.data && t.data[j]) {
                 memcpy(data[j], t.data[j], cols * sizeof(float32));
             }
-            if (t.grad && t.grad[j]) {
+            if (grad && t.grad && t.grad[j]) {
                 memcpy(grad[j], t.grad[j], cols * sizeof(float32));
             }
         }
+        telemetry::on_create(this);
+        track_alloc(rows, cols);
     }
 
     // Move constructor
@@ -156,10 +323,18 @@ public:
         // this->uuidstr = std::move(t.uuidstr);
         this->rows = t.rows;
         this->cols = t.cols;
+#if !NN_STRIP_NAMES
         this->name = std::move(t.name);
+#endif
+        this->op = t.op;
+        this->requires_grad = t.requires_grad;
         this->_backward = t._backward;
         this->left = std::move(t.left);
         this->right = std::move(t.right);
+        this->sparse = std::move(t.sparse);
+        this->segment = std::move(t.segment);
+        this->saved = std::move(t.saved);
+        this->attrs = t.attrs;
         this->data_holder = std::move(t.data_holder);
         this->grad_holder = std::move(t.grad_holder);
         this->data = this->data_holder.get();
@@ -169,23 +344,82 @@ public:
         t.grad = nullptr;
         t.rows = 0;
         t.cols = 0;
+
+        // Buffers change owner; the moved-from shell stays a live node
+        telemetry::on_create(this);
+        this->mem_data_ = t.mem_data_;
+        this->mem_grad_ = t.mem_grad_;
+        this->mem_nodes_ = t.mem_nodes_;
+        t.mem_data_ = t.mem_grad_ = 0;
+        t.mem_nodes_ = (long)sizeof(Tensor);
+        telemetry::add_bytes(MEM_NODES, t.mem_nodes_);
+    }
+
+    ~Tensor() {
+        track_release();
+        telemetry::on_destroy(this);
     }
 
     void setGrad(float32** new_grad) {
-        int r = rows;
-        grad_holder = std::shared_ptr<float32*[]>(new float32*[r],
-            [r](float32** p) {
-                for (int i = 0; i < r; i++) {
-                    delete[] p[i];
-                }
+        // Copy in place so grads bound to external storage stay bound
+        if (!grad) {
+            throw std::logic_error("Tensor does not require grad");
+        }
+        for (int j = 0; j < rows; j++) {
+            memcpy(grad[j], new_grad[j], cols * sizeof(float32));
+        }
+    }
+
+    // Move data and grad into caller-provided contiguous buffers of
+    // rows * cols floats each; the rows become views into them.
+    // keep_alive owns the buffers and is held until the tensor is freed.
+    // A bound tensor is a parameter, so it always requires grad.
+    void bind(float32* data_base, float32* grad_base, std::shared_ptr<void> keep_alive) {
+        for (int j = 0; j < rows; j++) {
+            memcpy(data_base + (size_t)j * cols, data[j], cols * sizeof(float32));
+            if (grad) {
+                memcpy(grad_base + (size_t)j * cols, grad[j], cols * sizeof(float32));
+            } else {
+                memset(grad_base + (size_t)j * cols, 0, cols * sizeof(float32));
+            }
+        }
+        if (!requires_grad) {
+            telemetry::add_bytes(MEM_NODES, (long)rows * sizeof(float32*));
+            mem_nodes_ += (long)rows * sizeof(float32*);
+            requires_grad = true;
+        }
+        data_holder = std::shared_ptr<float32*[]>(new float32*[rows],
+            [keep_alive](float32** p) {
+                delete[] p;
+            });
+        grad_holder = std::shared_ptr<float32*[]>(new float32*[rows],
+            [keep_alive](float32** p) {
                 delete[] p;
             });
+        data = data_holder.get();
         grad = grad_holder.get();
         for (int j = 0; j < rows; j++) {
-            grad[j] = new float32[cols];
-            memcpy(grad[j], new_grad[j], cols * sizeof(float32));
+            data[j] = data_base + (size_t)j * cols;
+            grad[j] = grad_base + (size_t)j * cols;
         }
+
+        telemetry::add_bytes(MEM_DATA, -mem_data_);
+        telemetry::add_bytes(MEM_GRAD, -mem_grad_);
+        mem_data_ = mem_grad_ = 0;
+    }
+    void set_name(const std::string& n) {
+#if !NN_STRIP_NAMES
+        name = n;
+#else
+        (void)n;
+#endif
     }
+
+    // Debug label: the name of a leaf, or the expression an op computes,
+    // e.g. "tanh((x*W1))". Built on each call; only the op symbol when
+    // names are stripped.
+    std::string label() const;
+
     Tensor& operator=(const Tensor& t);
     Tensor operator+(const Tensor& t) const;
     Tensor operator/(const Tensor& t) const;
@@ -194,15 +428,69 @@ public:
     Tensor operator-(const Tensor& t) const;
     
     Tensor lekyrelu(float leaky = 0.01);
+    Tensor tanh(Approx approx = Approx::Rational) const;
+    Tensor sigmoid(Approx approx = Approx::Rational) const;
+    Tensor gelu(Approx approx = Approx::Rational) const;
+    Tensor silu(Approx approx = Approx::Rational) const;
+    Tensor sum() const;
+    Tensor mean() const;
+    Tensor mse_loss(const Tensor& target) const;
+    Tensor checkpoint(const std::shared_ptr<Segment>& fn) const;
+    // Adds a 1 x cols bias to every row
+    Tensor add_bias(const Tensor& bias) const;
+    // 1-D convolution of this (length x in_channels) with a kernel laid out
+    // as (kernel_size * in_channels) x out_channels, row k * in_channels + c
+    // holding tap k of channel c. Lowered via im2col onto the GEMM kernels.
+    Tensor conv1d(const Tensor& kernel, int stride = 1, int padding = 0, int dilation = 1) const;
 
     void backadd();
     void backmul();
+    void backmul_left();
+    void backmul_right();
+    // Backpropagate from this tensor. A 1x1 root is seeded with grad 1;
+    // backprop() runs the same pass on whatever grad is already stored.
     void backward();
+    void backprop();
     void backdot();
     void backsub();
     void backleakyrelu();
+    void backtanh();
+    void backsigmoid();
+    void backgelu();
+    void backsilu();
+    void backsum();
+    void backmean();
+    void backmse();
+    void backcheckpoint();
+    void backbias();
+    void backconv1d();
+
+    // Magnitude pruning: zero the smallest |w| entries and switch the
+    // tensor to CSR kernels for operator*. Pruned weights stay zero.
+    void prune(float sparsity);
+    void prune_threshold(float threshold);
+    // Inference only: free the dense data and grad of a pruned tensor so
+    // the CSR copy is its only storage. The tensor stops requiring grad and
+    // may then only be used as a sparse operand of operator* or conv1d.
+    void release_dense();
+    // Back to dense kernels; rebuilds the dense rows if they were released
+    void densify();
 
     void update(float learning_rate) {
+        if (!grad) {
+            return;
+        }
+        if (sparse) {
+            // Masked update: only surviving weights move
+            for (int i = 0; i < this->rows; i++) {
+                for (int p = sparse->row_ptr[i]; p < sparse->row_ptr[i + 1]; p++) {
+                    int j = sparse->col_idx[p];
+                    data[i][j] -= learning_rate * grad[i][j];
+                    sparse->values[p] = data[i][j];
+                }
+            }
+            return;
+        }
         for (int i = 0; i < this->rows; i++) {
             for (int j = 0; j < this->cols; j++) {
                 data[i][j] -= learning_rate * grad[i][j];
@@ -210,6 +498,9 @@ public:
         }
     }
     void setgradzero() {
+        if (!grad) {
+            return;
+        }
         for (int i = 0; i < this->rows; i++) {
             for (int j = 0; j < this->cols; j++) {
                 grad[i][j] = 0;
@@ -232,4 +523,8 @@ public:
     // bool operator==(const Tensor* t) const {
     //     return uuid_compare(this->id, t->id) == 0;
     // }
-};
\ No newline at end of file
+};
+
+// One line per surviving tensor ("name rows x cols"). Requires a build
+// with -DNN_TRACK_LEAKS; otherwise returns an explanatory message.
+std::string tensor_leak_report();
\ No newline at end of file
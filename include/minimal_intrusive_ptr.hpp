@@ -2,6 +2,7 @@
 #define MINIMAL_INTRUSIVE_PTR_HPP
 
 #include <cstddef> 
+#include <functional>
 
 namespace minimal {
 
@@ -100,6 +101,20 @@ public:
         return px != nullptr;
     }
     
+    // Order by address so intrusive_ptr can key std::set/std::map
+    // (otherwise the implicit bool conversion would be compared).
+    friend bool operator<(const intrusive_ptr<T>& a, const intrusive_ptr<T>& b) {
+        return std::less<T*>()(a.px, b.px);
+    }
+
+    friend bool operator==(const intrusive_ptr<T>& a, const intrusive_ptr<T>& b) {
+        return a.px == b.px;
+    }
+
+    friend bool operator!=(const intrusive_ptr<T>& a, const intrusive_ptr<T>& b) {
+        return a.px != b.px;
+    }
+
     friend bool operator!=(const intrusive_ptr<T>& a, std::nullptr_t) {
         return a.px != nullptr;
     }
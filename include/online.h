@@ -0,0 +1,108 @@
+#pragma once
+
+#include <functional>
+#include <stdint.h>
+#include "value.h"
+#include "parameters.h"
+
+// Fixed-capacity ring of the most recent (x, y) samples. Storage is
+// inline, so pushing never allocates; the oldest sample is overwritten
+// once the ring is full.
+template <int Capacity, int InDim, int OutDim>
+class SampleRing {
+public:
+    SampleRing() : head_(0), count_(0) {}
+
+    void push(const float32* x, const float32* y) {
+        memcpy(x_[head_], x, InDim * sizeof(float32));
+        memcpy(y_[head_], y, OutDim * sizeof(float32));
+        head_ = (head_ + 1) % Capacity;
+        if (count_ < Capacity) {
+            count_++;
+        }
+    }
+
+    int size() const { return count_; }
+    bool full() const { return count_ == Capacity; }
+
+    // age 0 is the newest sample
+    const float32* x(int age) const { return x_[index(age)]; }
+    const float32* y(int age) const { return y_[index(age)]; }
+
+private:
+    int index(int age) const {
+        return (head_ - 1 - age + 2 * Capacity) % Capacity;
+    }
+
+    float32 x_[Capacity][InDim];
+    float32 y_[Capacity][OutDim];
+    int head_;
+    int count_;
+};
+
+// Incremental SGD on live samples. Every observed sample triggers one
+// mini-step over a fixed-size batch: the new sample plus Batch - 1 samples
+// replayed from the ring. Per-sample cost is therefore constant, and the
+// batch tensors are allocated once up front; the only allocations per step
+// are the graph nodes of one forward/backward, which are freed again.
+template <int Capacity, int InDim, int OutDim, int Batch>
+class OnlineTrainer {
+public:
+    typedef std::function<Value(Value &)> Model;
+
+    OnlineTrainer(Model model, ParameterRegistry &params, float learning_rate)
+        : model_(model),
+          params_(params),
+          learning_rate_(learning_rate),
+          x_batch_(Batch, InDim, nullptr, "online_x", false),
+          y_batch_(Batch, OutDim, nullptr, "online_y", false),
+          seed_(0x9E3779B9u),
+          steps_(0) {}
+
+    // Record a sample and take one training step once Batch samples are
+    // available. Returns the step loss, or a negative value while warming up.
+    float observe(const float32* x, const float32* y) {
+        ring_.push(x, y);
+        if (ring_.size() < Batch) {
+            return -1.0f;
+        }
+        return step();
+    }
+
+    float step() {
+        for (int i = 0; i < Batch; i++) {
+            int age = i == 0 ? 0 : (int)(next_random() % (uint32_t)ring_.size());
+            memcpy(x_batch_.ptr->data[i], ring_.x(age), InDim * sizeof(float32));
+            memcpy(y_batch_.ptr->data[i], ring_.y(age), OutDim * sizeof(float32));
+        }
+
+        Value out = model_(x_batch_);
+        Value loss = out.mse_loss(y_batch_);
+        loss.backward();
+        params_.step(learning_rate_);
+        params_.zero_grad();
+        steps_++;
+        return loss.item();
+    }
+
+    int samples() const { return ring_.size(); }
+    unsigned long steps() const { return steps_; }
+
+private:
+    uint32_t next_random() {
+        // xorshift32
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 17;
+        seed_ ^= seed_ << 5;
+        return seed_;
+    }
+
+    Model model_;
+    ParameterRegistry &params_;
+    float learning_rate_;
+    SampleRing<Capacity, InDim, OutDim> ring_;
+    Value x_batch_;
+    Value y_batch_;
+    uint32_t seed_;
+    unsigned long steps_;
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include "value.h"
+
+// Packs every registered parameter and its gradient into one contiguous
+// data array and one contiguous grad array. The tensors keep working as
+// before, but their rows become views into the flat buffers, so zero-grad,
+// the SGD update and the gradient norm are each a single linear sweep no
+// matter how many layers the model has.
+//
+//   ParameterRegistry params;
+//   params.add(W1);
+//   params.add(W2);
+//   params.pack();
+//   ...
+//   loss.backward();
+//   params.step(learning_rate);
+//   params.zero_grad();
+class ParameterRegistry {
+public:
+    ParameterRegistry() : size_(0), data_(nullptr), grad_(nullptr), packed_(false) {}
+
+    void add(Value &v) {
+        add(v.orig != nullptr ? v.orig.get() : v.ptr.get());
+    }
+
+    void add(Tensor *t) {
+        if (packed_) {
+            throw std::logic_error("Parameters already packed");
+        }
+        tensors_.push_back(minimal::intrusive_ptr<Tensor>(t));
+    }
+
+    // Allocate the flat buffers and rebind every registered tensor into them
+    void pack() {
+        if (packed_) {
+            return;
+        }
+        size_ = 0;
+        for (size_t i = 0; i < tensors_.size(); i++) {
+            size_ += (size_t)tensors_[i]->rows * tensors_[i]->cols;
+        }
+        // Freed when the last tensor viewing it goes away
+        long bytes = (long)(size_ * sizeof(float32));
+        std::shared_ptr<float32> storage(new float32[2 * size_](), [bytes](float32 *p) {
+            delete[] p;
+            telemetry::add_bytes(MEM_DATA, -bytes);
+            telemetry::add_bytes(MEM_GRAD, -bytes);
+        });
+        telemetry::add_bytes(MEM_DATA, bytes);
+        telemetry::add_bytes(MEM_GRAD, bytes);
+        data_ = storage.get();
+        grad_ = storage.get() + size_;
+
+        size_t offset = 0;
+        for (size_t i = 0; i < tensors_.size(); i++) {
+            Tensor *t = tensors_[i].get();
+            t->bind(data_ + offset, grad_ + offset, storage);
+            offset += (size_t)t->rows * t->cols;
+        }
+        packed_ = true;
+        refresh_sparsity();
+    }
+
+    // Rebuild the update mask; call again after pruning a packed parameter
+    void refresh_sparsity() {
+        sparse_.clear();
+        size_t offset = 0;
+        for (size_t i = 0; i < tensors_.size(); i++) {
+            Tensor *t = tensors_[i].get();
+            if (t->sparse) {
+                sparse_.push_back(SparseRange(t, offset));
+            }
+            offset += (size_t)t->rows * t->cols;
+        }
+        build_mask();
+    }
+
+    void zero_grad() {
+        memset(grad_, 0, size_ * sizeof(float32));
+    }
+
+    void step(float learning_rate) {
+        float32 *__restrict d = data_;
+        const float32 *__restrict g = grad_;
+        if (mask_.empty()) {
+            for (size_t i = 0; i < size_; i++) {
+                d[i] -= learning_rate * g[i];
+            }
+            return;
+        }
+        // Pruned entries have mask 0 and stay exactly zero
+        const float32 *__restrict m = mask_.data();
+        for (size_t i = 0; i < size_; i++) {
+            d[i] = (d[i] - learning_rate * g[i]) * m[i];
+        }
+        for (size_t i = 0; i < sparse_.size(); i++) {
+            sparse_[i].tensor->sparse->gather(sparse_[i].tensor->data);
+        }
+    }
+
+    float grad_norm() const {
+        const float32 *__restrict g = grad_;
+        float32 sum = 0.0f;
+        for (size_t i = 0; i < size_; i++) {
+            sum += g[i] * g[i];
+        }
+        return std::sqrt(sum);
+    }
+
+    // Scale all gradients together so their global norm is at most max_norm
+    float clip_grad_norm(float max_norm) {
+        float norm = grad_norm();
+        if (norm > max_norm) {
+            float scale = max_norm / norm;
+            for (size_t i = 0; i < size_; i++) {
+                grad_[i] *= scale;
+            }
+        }
+        return norm;
+    }
+
+    // Copy parameter values from another registry with the same layout
+    void load(const ParameterRegistry &other) {
+        if (other.size_ != size_) {
+            throw std::invalid_argument("Parameter layouts do not match");
+        }
+        memcpy(data_, other.data_, size_ * sizeof(float32));
+        for (size_t i = 0; i < sparse_.size(); i++) {
+            sparse_[i].tensor->sparse->gather(sparse_[i].tensor->data);
+        }
+    }
+
+    size_t size() const { return size_; }
+    float32 *data() { return data_; }
+    float32 *grad() { return grad_; }
+    int count() const { return (int)tensors_.size(); }
+    Tensor *tensor(int i) const { return tensors_[i].get(); }
+
+private:
+    struct SparseRange {
+        Tensor *tensor;
+        size_t offset;
+        SparseRange(Tensor *t, size_t o) : tensor(t), offset(o) {}
+    };
+
+    // 1 for trainable entries, 0 for pruned ones; empty when nothing is pruned
+    void build_mask() {
+        mask_.clear();
+        if (sparse_.empty()) {
+            return;
+        }
+        mask_.assign(size_, 1.0f);
+        for (size_t s = 0; s < sparse_.size(); s++) {
+            Tensor *t = sparse_[s].tensor;
+            float32 *m = mask_.data() + sparse_[s].offset;
+            for (int i = 0; i < t->rows * t->cols; i++) {
+                m[i] = 0.0f;
+            }
+            const CSRMatrix &csr = *t->sparse;
+            for (int i = 0; i < csr.rows; i++) {
+                for (int p = csr.row_ptr[i]; p < csr.row_ptr[i + 1]; p++) {
+                    m[(size_t)i * t->cols + csr.col_idx[p]] = 1.0f;
+                }
+            }
+        }
+    }
+
+    std::vector<minimal::intrusive_ptr<Tensor>> tensors_;
+    std::vector<SparseRange> sparse_;
+    std::vector<float32> mask_;
+    size_t size_;
+    float32 *data_;
+    float32 *grad_;
+    bool packed_;
+};
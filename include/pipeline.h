@@ -0,0 +1,177 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include "spsc_queue.h"
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+// Two-stage request pipeline: an ingest task parses input characters into
+// a preallocated SPSC queue, and the compute side drains it in batches.
+// On ESP32 the stages run as FreeRTOS tasks on separate cores; on host
+// builds std::thread and MemoryStream stand in.
+
+struct Request {
+    float x;
+    float y;
+    bool labelled;   // "x y" trains on the sample, "x" only predicts
+};
+
+// Incremental line parser with a fixed buffer; no heap, no String.
+// A line longer than the buffer is dropped whole and counted, rather
+// than parsed from its first characters.
+class RequestParser {
+public:
+    static const int MAX_LINE = 31;
+
+    RequestParser() : len_(0), overflow_(false), dropped_(0) {}
+
+    // Returns true when c completes a valid request in out
+    bool feed(char c, Request& out) {
+        if (c != '\n' && c != '\r') {
+            if (len_ < MAX_LINE) {
+                buf_[len_++] = c;
+            } else {
+                overflow_ = true;
+            }
+            return false;
+        }
+        if (overflow_) {
+            overflow_ = false;
+            len_ = 0;
+            dropped_++;
+            return false;
+        }
+        if (len_ == 0) {
+            return false;
+        }
+        buf_[len_] = '\0';
+        len_ = 0;
+
+        char* end = nullptr;
+        out.x = strtof(buf_, &end);
+        if (end == buf_) {
+            return false;
+        }
+        char* end_y = nullptr;
+        out.y = strtof(end, &end_y);
+        out.labelled = end_y != end;
+        return true;
+    }
+
+    // Lines dropped so far for exceeding MAX_LINE characters
+    unsigned long dropped() const { return dropped_; }
+
+private:
+    char buf_[MAX_LINE + 1];
+    int len_;
+    bool overflow_;
+    unsigned long dropped_;
+};
+
+// In-memory character source with the Stream read interface
+class MemoryStream {
+public:
+    explicit MemoryStream(const char* text) : text_(text), pos_(0), len_((int)strlen(text)) {}
+
+    int available() const { return len_ - pos_; }
+
+    int read() {
+        if (pos_ >= len_) {
+            return -1;
+        }
+        return (unsigned char)text_[pos_++];
+    }
+
+private:
+    const char* text_;
+    int pos_;
+    int len_;
+};
+
+inline void pipeline_yield() {
+#ifdef ESP_PLATFORM
+    vTaskDelay(1);
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Run fn(arg) in the background; pinned to `core` on ESP32
+inline bool start_task(void (*fn)(void*), void* arg, const char* name, int core,
+                       int stack_size = 4096, int priority = 1) {
+#ifdef ESP_PLATFORM
+    return xTaskCreatePinnedToCore(fn, name, stack_size, arg, priority, nullptr, core) == pdPASS;
+#else
+    (void)name;
+    (void)core;
+    (void)stack_size;
+    (void)priority;
+    std::thread(fn, arg).detach();
+    return true;
+#endif
+}
+
+// Producer stage. Reads characters from source and pushes parsed requests;
+// when the queue is full it waits, so compute applies back-pressure.
+template <typename Source, int Capacity>
+class IngestStage {
+public:
+    IngestStage(Source& source, SpscQueue<Request, Capacity>& queue)
+        : source_(source), queue_(queue), running_(false), dropped_(0) {}
+
+    bool start(int core) {
+        running_ = true;
+        return start_task(&IngestStage::task, this, "ingest", core);
+    }
+
+    void stop() { running_ = false; }
+
+    // Over-long lines dropped by the parser; safe to read from any task
+    unsigned long dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Process whatever input is currently available; returns requests queued
+    int poll() {
+        int queued = 0;
+        Request request;
+        while (source_.available() > 0) {
+            int c = source_.read();
+            if (c < 0) {
+                break;
+            }
+            if (parser_.feed((char)c, request)) {
+                while (!queue_.push(request)) {
+                    pipeline_yield();
+                }
+                queued++;
+            }
+        }
+        dropped_.store(parser_.dropped(), std::memory_order_relaxed);
+        return queued;
+    }
+
+private:
+    static void task(void* arg) {
+        IngestStage* self = static_cast<IngestStage*>(arg);
+        while (self->running_) {
+            if (self->poll() == 0) {
+                pipeline_yield();
+            }
+        }
+#ifdef ESP_PLATFORM
+        vTaskDelete(nullptr);
+#endif
+    }
+
+    Source& source_;
+    SpscQueue<Request, Capacity>& queue_;
+    RequestParser parser_;
+    std::atomic<bool> running_;
+    std::atomic<unsigned long> dropped_;
+};
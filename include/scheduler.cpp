@@ -0,0 +1,289 @@
+#include "scheduler.h"
+#include <algorithm>
+#include <unordered_map>
+
+#ifdef ESP_PLATFORM
+#include <esp_pthread.h>
+#endif
+
+namespace {
+
+// Index of the worker running on this thread, -1 outside the pool
+thread_local int current_worker = -1;
+
+// Matmuls below this many multiply-adds run their two products inline
+const long SPLIT_MIN_WORK = 4096;
+
+}
+
+WorkStealingPool::WorkStealingPool(int workers) : queued_(0), pending_(0), stop_(false) {
+    if (workers <= 0) {
+        workers = (int)std::thread::hardware_concurrency();
+    }
+    if (workers <= 0) {
+        workers = 1;
+    }
+    for (int i = 0; i < workers; i++) {
+        queues_.push_back(std::unique_ptr<Queue>(new Queue()));
+    }
+    for (int i = 1; i < workers; i++) {
+#ifdef ESP_PLATFORM
+        esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+        cfg.stack_size = 8192;
+        cfg.pin_to_core = i % portNUM_PROCESSORS;
+        esp_pthread_set_cfg(&cfg);
+#endif
+        threads_.push_back(std::thread(&WorkStealingPool::worker_loop, this, i));
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (size_t i = 0; i < threads_.size(); i++) {
+        threads_[i].join();
+    }
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    int target = current_worker >= 0 ? current_worker : 0;
+    pending_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> guard(queues_[target]->lock);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    queued_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock_);
+    }
+    wake_.notify_one();
+}
+
+bool WorkStealingPool::run_one(int self) {
+    std::function<void()> task;
+    int n = (int)queues_.size();
+    for (int k = 0; k < n && !task; k++) {
+        Queue& q = *queues_[(self + k) % n];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.tasks.empty()) {
+            continue;
+        }
+        // Own deque LIFO for locality, steal FIFO from the others
+        if (k == 0) {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        } else {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+    queued_.fetch_sub(1);
+    task();
+    pending_.fetch_sub(1);
+    return true;
+}
+
+void WorkStealingPool::worker_loop(int index) {
+    current_worker = index;
+    while (true) {
+        if (run_one(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_lock_);
+        wake_.wait(lock, [this] { return stop_ || queued_.load() > 0; });
+        if (stop_) {
+            return;
+        }
+    }
+}
+
+void WorkStealingPool::wait() {
+    int previous = current_worker;
+    current_worker = 0;
+    while (pending_.load() > 0) {
+        if (!run_one(0)) {
+            std::this_thread::yield();
+        }
+    }
+    current_worker = previous;
+}
+
+namespace {
+
+struct BackwardState {
+    WorkStealingPool* pool;
+    std::vector<minimal::intrusive_ptr<Tensor>> nodes;   // keeps the graph alive
+    std::vector<int> left;                               // child indices, -1 if none
+    std::vector<int> right;
+    std::vector<std::vector<int>> after;                 // nodes ordered behind this one
+    std::unique_ptr<std::atomic<int>[]> waits;           // consumers and predecessors still to run
+    std::unique_ptr<std::atomic<int>[]> parts;           // unfinished split halves
+};
+
+void schedule(BackwardState& s, int n);
+
+void release(BackwardState& s, int n) {
+    if (--s.waits[n] == 0) {
+        schedule(s, n);
+    }
+}
+
+// n has written its children: unblock them and the next writer of each
+void finish(BackwardState& s, int n) {
+    if (s.left[n] >= 0) {
+        release(s, s.left[n]);
+    }
+    if (s.right[n] >= 0) {
+        release(s, s.right[n]);
+    }
+    for (size_t i = 0; i < s.after[n].size(); i++) {
+        release(s, s.after[n][i]);
+    }
+}
+
+void run_half(BackwardState& s, int n, bool left_half) {
+    Tensor* t = s.nodes[n].get();
+    if (left_half) {
+        t->backmul_left();
+    } else {
+        t->backmul_right();
+    }
+    if (s.parts[n].fetch_sub(1) == 1) {
+        finish(s, n);
+    }
+}
+
+void schedule(BackwardState& s, int n) {
+    Tensor* t = s.nodes[n].get();
+    if (!t->_backward || !t->requires_grad) {
+        // Leaves and constant subgraphs have nothing to run but may still have children
+        finish(s, n);
+        return;
+    }
+    BackwardState* state = &s;
+    // The halves write different children, so they may overlap
+    if (t->_backward == &Tensor::backmul && t->left && t->right && t->left != t->right
+        && t->left->requires_grad && t->right->requires_grad
+        && (long)t->rows * t->cols * t->left->cols >= SPLIT_MIN_WORK) {
+        s.parts[n] = 2;
+        s.pool->submit([state, n] { run_half(*state, n, true); });
+        s.pool->submit([state, n] { run_half(*state, n, false); });
+        return;
+    }
+    s.pool->submit([state, n] {
+        Tensor* node = state->nodes[n].get();
+        (node->*(node->_backward))();
+        finish(*state, n);
+    });
+}
+
+// Position of each node in the order Tensor::backward() runs them: the
+// reverse of a left-first post-order from the root
+std::vector<int> sequential_rank(const BackwardState& s) {
+    int n = (int)s.nodes.size();
+    std::vector<int> rank(n, -1);
+    std::vector<char> seen(n, 0);
+    std::vector<std::pair<int, int>> stack(1, std::make_pair(0, 0));
+    seen[0] = 1;
+    int next = n - 1;
+    while (!stack.empty()) {
+        int node = stack.back().first;
+        int& step = stack.back().second;
+        int child = step == 0 ? s.left[node] : step == 1 ? s.right[node] : -2;
+        step++;
+        if (child == -2) {
+            rank[node] = next--;
+            stack.pop_back();
+        } else if (child >= 0 && !seen[child]) {
+            seen[child] = 1;
+            stack.push_back(std::make_pair(child, 0));
+        }
+    }
+    return rank;
+}
+
+}
+
+void parallel_backward(Tensor* root, WorkStealingPool& pool) {
+    BackwardState s;
+    s.pool = &pool;
+
+    // Collect the graph iteratively and number its nodes
+    std::unordered_map<Tensor*, int> index;
+    std::vector<Tensor*> stack(1, root);
+    while (!stack.empty()) {
+        Tensor* t = stack.back();
+        stack.pop_back();
+        if (!t || index.count(t)) {
+            continue;
+        }
+        index[t] = (int)s.nodes.size();
+        s.nodes.push_back(minimal::intrusive_ptr<Tensor>(t));
+        stack.push_back(t->left.get());
+        stack.push_back(t->right.get());
+    }
+
+    int n = (int)s.nodes.size();
+    s.left.assign(n, -1);
+    s.right.assign(n, -1);
+    s.after.assign(n, std::vector<int>());
+    s.waits.reset(new std::atomic<int>[n]);
+    s.parts.reset(new std::atomic<int>[n]);
+    for (int i = 0; i < n; i++) {
+        s.waits[i] = 0;
+        s.parts[i] = 0;
+    }
+    std::vector<std::vector<int>> writers(n);
+    for (int i = 0; i < n; i++) {
+        Tensor* t = s.nodes[i].get();
+        if (t->left) {
+            s.left[i] = index[t->left.get()];
+            s.waits[s.left[i]]++;
+            writers[s.left[i]].push_back(i);
+        }
+        if (t->right) {
+            s.right[i] = index[t->right.get()];
+            s.waits[s.right[i]]++;
+            writers[s.right[i]].push_back(i);
+        }
+    }
+
+    // Every add into a grad is followed by clip_gradient, so the result
+    // depends on the order of the writers. Chain the consumers of each
+    // shared tensor in sequential order: gradients then match
+    // Tensor::backward() bit for bit, and only writers of disjoint
+    // tensors overlap.
+    std::vector<int> rank = sequential_rank(s);
+    for (int c = 0; c < n; c++) {
+        std::vector<int>& w = writers[c];
+        if (w.size() < 2) {
+            continue;
+        }
+        std::sort(w.begin(), w.end(), [&rank](int a, int b) { return rank[a] < rank[b]; });
+        w.erase(std::unique(w.begin(), w.end()), w.end());
+        for (size_t k = 1; k < w.size(); k++) {
+            s.after[w[k - 1]].push_back(w[k]);
+            s.waits[w[k]]++;
+        }
+    }
+
+    // A 1x1 root is a loss: dL/dL = 1, as in Tensor::backward()
+    if (root->rows == 1 && root->cols == 1 && root->grad) {
+        root->grad[0][0] = 1.0f;
+    }
+    schedule(s, 0);
+    pool.wait();
+
+    for (int i = 0; i < n; i++) {
+        s.nodes[i]->left = nullptr;
+        s.nodes[i]->right = nullptr;
+        s.nodes[i]->saved.reset();
+        s.nodes[i]->_backward = nullptr;
+    }
+}
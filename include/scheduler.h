@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "matrix.h"
+
+// Work-stealing thread pool. Each worker owns a deque: it pushes and pops
+// its own tasks at the back and, when idle, steals from the front of the
+// others. The thread calling wait() joins in as worker 0, so a pool of N
+// workers starts N - 1 threads. On ESP32 the threads are pinned round-robin
+// to the available cores.
+class WorkStealingPool {
+public:
+    // workers <= 0 uses std::thread::hardware_concurrency()
+    explicit WorkStealingPool(int workers = 0);
+    ~WorkStealingPool();
+
+    void submit(std::function<void()> task);
+
+    // Run tasks on the calling thread until every submitted task finished.
+    // Only one external thread may wait on a pool at a time.
+    void wait();
+
+    int size() const { return (int)queues_.size(); }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool run_one(int self);
+    void worker_loop(int index);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<int> queued_;    // tasks sitting in deques
+    std::atomic<int> pending_;   // tasks submitted and not yet finished
+    std::atomic<bool> stop_;
+    std::mutex sleep_lock_;
+    std::condition_variable wake_;
+
+    WorkStealingPool(const WorkStealingPool&);
+    WorkStealingPool& operator=(const WorkStealingPool&);
+};
+
+// Backward pass over the graph rooted at root, scheduled by dependency
+// counting: a node becomes ready once every consumer has pushed its
+// gradient into it, and ready nodes run on the pool. Consumers of a
+// shared tensor take turns in the order Tensor::backward() would run
+// them, so accumulation (and its per-step clipping) is race-free and the
+// gradients are identical to the sequential pass. The two gradient
+// products of a large matmul run as separate tasks.
+//
+// Checkpointed segments replay their inner backward sequentially inside
+// one task; parameters used inside a segment should not also be written
+// by other branches running at the same time.
+void parallel_backward(Tensor* root, WorkStealingPool& pool);
@@ -0,0 +1,113 @@
+#include "sparse.h"
+#include <cstring>
+
+CSRMatrix CSRMatrix::from_dense(float32** data, int rows, int cols) {
+    if (cols > 65535) {
+        throw std::invalid_argument("CSRMatrix supports at most 65535 columns");
+    }
+    CSRMatrix m;
+    m.rows = rows;
+    m.cols = cols;
+    m.row_ptr.reserve(rows + 1);
+    m.row_ptr.push_back(0);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            if (data[i][j] != 0.0f) {
+                m.col_idx.push_back((uint16_t)j);
+                m.values.push_back(data[i][j]);
+            }
+        }
+        m.row_ptr.push_back((int)m.values.size());
+    }
+    return m;
+}
+
+void CSRMatrix::gather(float32** data) {
+    for (int i = 0; i < rows; i++) {
+        for (int p = row_ptr[i]; p < row_ptr[i + 1]; p++) {
+            values[p] = data[i][col_idx[p]];
+        }
+    }
+}
+
+void spmm_dense_csr(float32** A, int m, int k, const CSRMatrix& B, float32** out) {
+    for (int i = 0; i < m; i++) {
+        memset(out[i], 0, B.cols * sizeof(float32));
+        for (int j = 0; j < k; j++) {
+            float32 a = A[i][j];
+            if (a == 0.0f) {
+                continue;
+            }
+            for (int p = B.row_ptr[j]; p < B.row_ptr[j + 1]; p++) {
+                out[i][B.col_idx[p]] += a * B.values[p];
+            }
+        }
+    }
+}
+
+void spmm_csr_dense(const CSRMatrix& A, float32** B, int n, float32** out) {
+    for (int i = 0; i < A.rows; i++) {
+        memset(out[i], 0, n * sizeof(float32));
+        for (int p = A.row_ptr[i]; p < A.row_ptr[i + 1]; p++) {
+            float32 v = A.values[p];
+            float32* b = B[A.col_idx[p]];
+            for (int j = 0; j < n; j++) {
+                out[i][j] += v * b[j];
+            }
+        }
+    }
+}
+
+void spmm_dense_csr_backward(float32** A, int m, int k, const CSRMatrix& B,
+                             float32** G, float32** dA, float32** dB) {
+    // dL/dA = G * B^T
+    if (dA) {
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < k; j++) {
+                float32 acc = 0.0f;
+                for (int p = B.row_ptr[j]; p < B.row_ptr[j + 1]; p++) {
+                    acc += G[i][B.col_idx[p]] * B.values[p];
+                }
+                dA[i][j] += acc;
+            }
+        }
+    }
+    // dL/dB = A^T * G, restricted to the stored pattern
+    if (dB) {
+        for (int j = 0; j < k; j++) {
+            for (int p = B.row_ptr[j]; p < B.row_ptr[j + 1]; p++) {
+                int c = B.col_idx[p];
+                float32 acc = 0.0f;
+                for (int i = 0; i < m; i++) {
+                    acc += A[i][j] * G[i][c];
+                }
+                dB[j][c] += acc;
+            }
+        }
+    }
+}
+
+void spmm_csr_dense_backward(const CSRMatrix& A, float32** B, int n,
+                             float32** G, float32** dA, float32** dB) {
+    for (int i = 0; i < A.rows; i++) {
+        for (int p = A.row_ptr[i]; p < A.row_ptr[i + 1]; p++) {
+            int k = A.col_idx[p];
+            float32 v = A.values[p];
+            float32* b = B[k];
+            if (dA) {
+                // dL/dA = G * B^T, restricted to the stored pattern
+                float32 acc = 0.0f;
+                for (int j = 0; j < n; j++) {
+                    acc += G[i][j] * b[j];
+                }
+                dA[i][k] += acc;
+            }
+            if (dB) {
+                // dL/dB = A^T * G
+                for (int j = 0; j < n; j++) {
+                    dB[k][j] += v * G[i][j];
+                }
+            }
+        }
+    }
+}
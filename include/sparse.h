@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stdexcept>
+
+typedef float float32;
+
+// Compressed sparse row storage for a pruned weight matrix.
+// Only the surviving (non-pruned) entries are stored, so memory and
+// multiply cost scale with nnz instead of rows * cols.
+class CSRMatrix {
+public:
+    int rows, cols;
+    std::vector<int> row_ptr;        // rows + 1 offsets into col_idx/values
+    std::vector<uint16_t> col_idx;   // column of each stored entry
+    std::vector<float32> values;     // value of each stored entry
+
+    CSRMatrix() : rows(0), cols(0) {}
+
+    // Build the sparsity pattern from the non-zero entries of a dense matrix.
+    static CSRMatrix from_dense(float32** data, int rows, int cols);
+
+    int nnz() const { return (int)values.size(); }
+
+    float density() const {
+        return rows * cols > 0 ? (float)nnz() / (float)(rows * cols) : 0.0f;
+    }
+
+    size_t bytes() const {
+        return row_ptr.size() * sizeof(int)
+             + col_idx.size() * sizeof(uint16_t)
+             + values.size() * sizeof(float32);
+    }
+
+    // Refresh stored values from the dense buffer (pattern stays fixed).
+    void gather(float32** data);
+};
+
+// out (m x n) = A (m x k, dense) * B (k x n, sparse)
+void spmm_dense_csr(float32** A, int m, int k, const CSRMatrix& B, float32** out);
+// out (m x n) = A (m x k, sparse) * B (k x n, dense)
+void spmm_csr_dense(const CSRMatrix& A, float32** B, int n, float32** out);
+
+// Gradients of out = A * B with B sparse. dA += G * B^T, and dB only at
+// the stored entries of B so pruned weights never receive gradient.
+void spmm_dense_csr_backward(float32** A, int m, int k, const CSRMatrix& B,
+                             float32** G, float32** dA, float32** dB);
+// Gradients of out = A * B with A sparse. dA only at stored entries, dB += A^T * G.
+void spmm_csr_dense_backward(const CSRMatrix& A, float32** B, int n,
+                             float32** G, float32** dA, float32** dB);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// Lock-free single-producer/single-consumer ring. The producer only
+// writes tail_ and the consumer only writes head_, so each index has a
+// single writer and acquire/release ordering is enough. Capacity must be
+// a power of two; storage is inline and never reallocated.
+template <typename T, int Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : head_(0), tail_(0) {}
+
+    // Producer side. Returns false when the queue is full.
+    bool push(const T& item) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == (uint32_t)Capacity) {
+            return false;
+        }
+        buffer_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when the queue is empty.
+    bool pop(T& item) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (tail_.load(std::memory_order_acquire) == head) {
+            return false;
+        }
+        item = buffer_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Pops up to max items in one go and returns the count.
+    int pop_batch(T* out, int max) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        uint32_t available = tail_.load(std::memory_order_acquire) - head;
+        int n = (int)available < max ? (int)available : max;
+        for (int i = 0; i < n; i++) {
+            out[i] = buffer_[(head + i) & (Capacity - 1)];
+        }
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    int size() const {
+        return (int)(tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire));
+    }
+
+private:
+    T buffer_[Capacity];
+    // Kept on separate cache lines so producer and consumer do not contend
+    alignas(64) std::atomic<uint32_t> head_;
+    alignas(64) std::atomic<uint32_t> tail_;
+};
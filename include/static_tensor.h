@@ -0,0 +1,178 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <stdexcept>
+#include "matrix.h"
+#include "activation.h"
+
+// Fixed-shape tensor for small layers whose dimensions are known at
+// compile time. Storage is inline (no heap), shapes are template
+// parameters so mismatched products fail to compile, and inner loops up
+// to STATIC_UNROLL_LIMIT iterations are unrolled through templates.
+
+const int STATIC_UNROLL_LIMIT = 16;
+
+namespace static_detail {
+
+template <int N>
+struct Unroll {
+    template <typename F>
+    static inline void run(F& f) {
+        Unroll<N - 1>::run(f);
+        f(N - 1);
+    }
+};
+
+template <>
+struct Unroll<0> {
+    template <typename F>
+    static inline void run(F&) {}
+};
+
+// Unrolled when N is small, a plain loop otherwise
+template <int N, bool Small = (N <= STATIC_UNROLL_LIMIT)>
+struct Loop {
+    template <typename F>
+    static inline void run(F& f) {
+        Unroll<N>::run(f);
+    }
+};
+
+template <int N>
+struct Loop<N, false> {
+    template <typename F>
+    static inline void run(F& f) {
+        for (int i = 0; i < N; i++) {
+            f(i);
+        }
+    }
+};
+
+}
+
+template <int R, int C>
+class StaticTensor {
+public:
+    static constexpr int rows = R;
+    static constexpr int cols = C;
+    std::array<float32, R * C> data;  // row-major
+
+    StaticTensor() : data() {}
+
+    explicit StaticTensor(const Tensor& t) {
+        load(t);
+    }
+
+    float32& operator()(int i, int j) { return data[i * C + j]; }
+    const float32& operator()(int i, int j) const { return data[i * C + j]; }
+    float32* row(int i) { return &data[i * C]; }
+    const float32* row(int i) const { return &data[i * C]; }
+
+    // Copy values from a runtime tensor, e.g. trained Value parameters
+    void load(const Tensor& t) {
+        if (t.rows != R || t.cols != C) {
+            throw std::invalid_argument("Tensor shape does not match StaticTensor");
+        }
+        for (int i = 0; i < R; i++) {
+            memcpy(row(i), t.data[i], C * sizeof(float32));
+        }
+    }
+
+    // Copy values back into a runtime tensor of the same shape
+    void store(Tensor& t) const {
+        if (t.rows != R || t.cols != C) {
+            throw std::invalid_argument("Tensor shape does not match StaticTensor");
+        }
+        for (int i = 0; i < R; i++) {
+            memcpy(t.data[i], row(i), C * sizeof(float32));
+        }
+    }
+
+    // New autograd leaf holding a copy of this tensor
+    Tensor* to_tensor(const std::string& name = "") const {
+        Tensor* t = new Tensor(R, C, nullptr, name);
+        store(*t);
+        return t;
+    }
+
+    template <int K>
+    StaticTensor<R, K> operator*(const StaticTensor<C, K>& b) const {
+        StaticTensor<R, K> out;
+        mul_into(b, out);
+        return out;
+    }
+
+    // out = this * b with no temporary; for callers on a small stack that
+    // keep out in static storage
+    template <int K>
+    void mul_into(const StaticTensor<C, K>& b, StaticTensor<R, K>& out) const {
+        out.data.fill(0.0f);
+        for (int i = 0; i < R; i++) {
+            const float32* a = row(i);
+            float32* o = out.row(i);
+            auto inner = [&](int k) {
+                const float32 av = a[k];
+                const float32* br = b.row(k);
+                auto axpy = [&](int j) { o[j] += av * br[j]; };
+                static_detail::Loop<K>::run(axpy);
+            };
+            static_detail::Loop<C>::run(inner);
+        }
+    }
+
+    StaticTensor operator+(const StaticTensor& b) const {
+        StaticTensor out;
+        auto f = [&](int i) { out.data[i] = data[i] + b.data[i]; };
+        static_detail::Loop<R * C>::run(f);
+        return out;
+    }
+
+    StaticTensor operator-(const StaticTensor& b) const {
+        StaticTensor out;
+        auto f = [&](int i) { out.data[i] = data[i] - b.data[i]; };
+        static_detail::Loop<R * C>::run(f);
+        return out;
+    }
+
+    StaticTensor leakyrelu(float leaky = 0.01f) const {
+        StaticTensor out;
+        auto f = [&](int i) { out.data[i] = data[i] > 0 ? data[i] : leaky * data[i]; };
+        static_detail::Loop<R * C>::run(f);
+        return out;
+    }
+
+    void leakyrelu_inplace(float leaky = 0.01f) {
+        auto f = [&](int i) { data[i] = data[i] > 0 ? data[i] : leaky * data[i]; };
+        static_detail::Loop<R * C>::run(f);
+    }
+
+    StaticTensor tanh(Approx approx = Approx::Rational) const {
+        StaticTensor out;
+        activation::tanh_row(data.data(), out.data.data(), R * C, approx);
+        return out;
+    }
+
+    StaticTensor sigmoid(Approx approx = Approx::Rational) const {
+        StaticTensor out;
+        activation::sigmoid_row(data.data(), out.data.data(), R * C, approx);
+        return out;
+    }
+
+    StaticTensor gelu(Approx approx = Approx::Rational) const {
+        StaticTensor out;
+        activation::gelu_row(data.data(), out.data.data(), R * C, approx);
+        return out;
+    }
+
+    StaticTensor silu(Approx approx = Approx::Rational) const {
+        StaticTensor out;
+        activation::silu_row(data.data(), out.data.data(), R * C, approx);
+        return out;
+    }
+};
+
+template <int R, int C>
+constexpr int StaticTensor<R, C>::rows;
+template <int R, int C>
+constexpr int StaticTensor<R, C>::cols;
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stddef.h>
+
+// Tensor memory accounting. Enabled by default; build with
+// -DNN_TELEMETRY=0 to compile the counters out. Build with
+// -DNN_TRACK_LEAKS to also keep a registry of live tensors for
+// tensor_leak_report().
+
+#ifndef NN_TELEMETRY
+#define NN_TELEMETRY 1
+#endif
+
+class Tensor;
+
+enum MemCategory {
+    MEM_DATA = 0,    // value buffers
+    MEM_GRAD = 1,    // gradient buffers
+    MEM_NODES = 2,   // Tensor objects and their row pointer tables
+    MEM_CATEGORIES = 3
+};
+
+struct MemorySnapshot {
+    long live_tensors;
+    long bytes[MEM_CATEGORIES];
+    long peak_tensors;        // since reset_peaks()
+    long peak_bytes;          // since reset_peaks(), all categories
+    long step_peak_bytes;     // since begin_step(), all categories
+
+    long total_bytes() const {
+        return bytes[MEM_DATA] + bytes[MEM_GRAD] + bytes[MEM_NODES];
+    }
+};
+
+namespace telemetry {
+
+struct State {
+    std::atomic<long> live_tensors;
+    std::atomic<long> bytes[MEM_CATEGORIES];
+    std::atomic<long> total;
+    std::atomic<long> peak_tensors;
+    std::atomic<long> peak_bytes;
+    std::atomic<long> step_peak_bytes;
+#ifdef NN_TRACK_LEAKS
+    std::mutex lock;
+    std::set<const Tensor*> live;
+#endif
+
+    State() : live_tensors(0), total(0), peak_tensors(0), peak_bytes(0), step_peak_bytes(0) {
+        for (int i = 0; i < MEM_CATEGORIES; i++) {
+            bytes[i] = 0;
+        }
+    }
+};
+
+inline State& state() {
+    static State s;
+    return s;
+}
+
+inline void raise_to(std::atomic<long>& peak, long value) {
+    long current = peak.load(std::memory_order_relaxed);
+    while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+inline void add_bytes(MemCategory category, long delta) {
+#if NN_TELEMETRY
+    State& s = state();
+    s.bytes[category].fetch_add(delta, std::memory_order_relaxed);
+    long total = s.total.fetch_add(delta, std::memory_order_relaxed) + delta;
+    if (delta > 0) {
+        raise_to(s.peak_bytes, total);
+        raise_to(s.step_peak_bytes, total);
+    }
+#else
+    (void)category;
+    (void)delta;
+#endif
+}
+
+inline void on_create(const Tensor* t) {
+#if NN_TELEMETRY
+    State& s = state();
+    raise_to(s.peak_tensors, s.live_tensors.fetch_add(1, std::memory_order_relaxed) + 1);
+#ifdef NN_TRACK_LEAKS
+    std::lock_guard<std::mutex> guard(s.lock);
+    s.live.insert(t);
+#endif
+#endif
+    (void)t;
+}
+
+inline void on_destroy(const Tensor* t) {
+#if NN_TELEMETRY
+    State& s = state();
+    s.live_tensors.fetch_sub(1, std::memory_order_relaxed);
+#ifdef NN_TRACK_LEAKS
+    std::lock_guard<std::mutex> guard(s.lock);
+    s.live.erase(t);
+#endif
+#endif
+    (void)t;
+}
+
+inline MemorySnapshot snapshot() {
+    State& s = state();
+    MemorySnapshot m;
+    m.live_tensors = s.live_tensors.load();
+    for (int i = 0; i < MEM_CATEGORIES; i++) {
+        m.bytes[i] = s.bytes[i].load();
+    }
+    m.peak_tensors = s.peak_tensors.load();
+    m.peak_bytes = s.peak_bytes.load();
+    m.step_peak_bytes = s.step_peak_bytes.load();
+    return m;
+}
+
+// Start a new step: the step high-water mark restarts from current usage
+inline void begin_step() {
+    State& s = state();
+    s.step_peak_bytes.store(s.total.load());
+}
+
+inline void reset_peaks() {
+    State& s = state();
+    s.peak_tensors.store(s.live_tensors.load());
+    s.peak_bytes.store(s.total.load());
+    s.step_peak_bytes.store(s.total.load());
+}
+
+}
@@ -2,6 +2,8 @@
 
 #include <Arduino.h>
 #include "matrix.h"
+#include "static_tensor.h"
+#include "scheduler.h"
 #include <cstring>
 #include <cmath>
 #include "minimal_intrusive_ptr.hpp"
@@ -24,12 +26,26 @@ public:
         ptr = t;
     }
 
-    Value(int row, int cols, float **data, std::string name)
+    Value(int row, int cols, float **data, std::string name, bool requires_grad = true)
     {
-        ptr = minimal::intrusive_ptr<Tensor>(new Tensor(row, cols, data, name));
+        ptr = minimal::intrusive_ptr<Tensor>(new Tensor(row, cols, data, name, requires_grad));
         orig = ptr;
     }
 
+    template <int R, int C>
+    Value(const StaticTensor<R, C> &t, std::string name)
+    {
+        ptr = minimal::intrusive_ptr<Tensor>(t.to_tensor(name));
+        orig = ptr;
+    }
+
+    // Copy the current values into a fixed-shape tensor for inference
+    template <int R, int C>
+    void copy_to(StaticTensor<R, C> &t) const
+    {
+        t.load(orig != nullptr ? *orig : *ptr);
+    }
+
     Value &operator=(const Value &other)
     {
         if (this != &other)
@@ -84,6 +100,32 @@ public:
         return Value(new Tensor(*ptr - *other.ptr));
     }
 
+    // Adds a 1 x cols bias row to every row
+    Value add_bias(const Value &bias) const
+    {
+        if (ptr->_backward == nullptr && orig != nullptr)
+        {
+            this->ptr = this->orig;
+        }
+        return Value(new Tensor(ptr->add_bias(*bias.ptr)));
+    }
+
+    // 1-D convolution of a (length x in_channels) signal with a
+    // (kernel_size * in_channels) x out_channels kernel
+    Value conv1d(const Value &kernel, int stride = 1, int padding = 0, int dilation = 1) const
+    {
+        if (ptr->_backward == nullptr && orig != nullptr)
+        {
+            this->ptr = this->orig;
+        }
+        return Value(new Tensor(ptr->conv1d(*kernel.ptr, stride, padding, dilation)));
+    }
+
+    Value conv1d(const Value &kernel, const Value &bias, int stride = 1, int padding = 0, int dilation = 1) const
+    {
+        return conv1d(kernel, stride, padding, dilation).add_bias(bias);
+    }
+
     Value leakyrelu(float leaky = 0.01)
     {
         if (ptr->_backward == nullptr && orig != nullptr)
@@ -93,6 +135,90 @@ public:
         return Value(new Tensor(ptr->lekyrelu(leaky)));
     }
 
+    Value tanh(Approx approx = Approx::Rational)
+    {
+        if (ptr->_backward == nullptr && orig != nullptr)
+        {
+            this->ptr = this->orig;
+        }
+        return Value(new Tensor(ptr->tanh(approx)));
+    }
+
+    Value sigmoid(Approx approx = Approx::Rational)
+    {
+        if (ptr->_backward == nullptr && orig != nullptr)
+        {
+            this->ptr = this->orig;
+        }
+        return Value(new Tensor(ptr->sigmoid(approx)));
+    }
+
+    Value gelu(Approx approx = Approx::Rational)
+    {
+        if (ptr->_backward == nullptr && orig != nullptr)
+        {
+            this->ptr = this->orig;
+        }
+        return Value(new Tensor(ptr->gelu(approx)));
+    }
+
+    Value silu(Approx approx = Approx::Rational)
+    {
+        if (ptr->_backward == nullptr && orig != nullptr)
+        {
+            this->ptr = this->orig;
+        }
+        return Value(new Tensor(ptr->silu(approx)));
+    }
+
+    Value sum()
+    {
+        if (ptr->_backward == nullptr && orig != nullptr)
+        {
+            this->ptr = this->orig;
+        }
+        return Value(new Tensor(ptr->sum()));
+    }
+
+    Value mean()
+    {
+        if (ptr->_backward == nullptr && orig != nullptr)
+        {
+            this->ptr = this->orig;
+        }
+        return Value(new Tensor(ptr->mean()));
+    }
+
+    Value mse_loss(const Value &target)
+    {
+        if (ptr->_backward == nullptr && orig != nullptr)
+        {
+            this->ptr = this->orig;
+        }
+        return Value(new Tensor(ptr->mse_loss(*target.ptr)));
+    }
+
+    // Run fn as a checkpointed segment: its interior activations are freed
+    // after the forward pass and recomputed during backward.
+    Value checkpoint(std::function<Value(Value &)> fn)
+    {
+        if (ptr->_backward == nullptr && orig != nullptr)
+        {
+            this->ptr = this->orig;
+        }
+        auto segment = std::make_shared<Tensor::Segment>(
+            [fn](const minimal::intrusive_ptr<Tensor> &in) {
+                Value x(in.get());
+                return fn(x).ptr;
+            });
+        return Value(new Tensor(ptr->checkpoint(segment)));
+    }
+
+    float item() const
+    {
+        return ptr->data[0][0];
+    }
+
     void setgrad(float **grad)
     {
         ptr->setGrad(grad);
@@ -109,8 +235,20 @@ public:
         ptr->backward();
     }
 
+    // Backward with independent branches running in parallel on pool
+    void backward(WorkStealingPool &pool)
+    {
+        parallel_backward(ptr.get(), pool);
+    }
+
     void printgrad()
     {
+        Tensor *t = orig != nullptr ? orig.get() : ptr.get();
+        if (!t->grad)
+        {
+            Serial.println("(no grad)");
+            return;
+        }
         if (orig == nullptr)
         {
             for (int i = 0; i < ptr->rows; i++)
@@ -142,7 +280,9 @@ public:
         if (orig != nullptr)
         {
             Serial.print("Original Data \n");
-            Serial.println(orig->name.c_str());
+#if !NN_STRIP_NAMES
+            Serial.println(orig->label().c_str());
+#endif
             for (int i = 0; i < orig->rows; i++)
             {
                 for (int j = 0; j < orig->cols; j++)
@@ -156,7 +296,9 @@ public:
         else
         {
             Serial.print("Data ");
-            Serial.println(ptr->name.c_str());
+#if !NN_STRIP_NAMES
+            Serial.println(ptr->label().c_str());
+#endif
             for (int i = 0; i < ptr->rows; i++)
             {
                 for (int j = 0; j < ptr->cols; j++)
@@ -169,6 +311,33 @@ public:
         }
     }
 
+    void prune(float sparsity)
+    {
+        if (orig != nullptr) {
+            this->ptr = this->orig;
+            orig->prune(sparsity);
+        } else if (ptr != nullptr) {
+            ptr->prune(sparsity);
+        }
+    }
+
+    // Free the dense copy of a pruned inference-only weight
+    void release_dense()
+    {
+        if (orig != nullptr) {
+            this->ptr = this->orig;
+            orig->release_dense();
+        } else if (ptr != nullptr) {
+            ptr->release_dense();
+        }
+    }
+
+    float density() const
+    {
+        Tensor *t = orig != nullptr ? orig.get() : ptr.get();
+        return t->sparse ? t->sparse->density() : 1.0f;
+    }
+
     void update(float learning_rate)
     {
         if (orig != nullptr) {
@@ -2,10 +2,18 @@
 #include <matrix.h>
 #include <esp_heap_caps.h>
 #include <value.h>
+#include <online.h>
+#include <parameters.h>
+#include <bake.h>
+#include <pipeline.h>
+#include <data_parallel.h>
+#include <codegen.h>
 
 // Global variables to store model parameters
 Value* W1_global = nullptr;
 Value* W2_global = nullptr;
+ParameterRegistry params;           // W1 and W2 packed into one flat buffer
+DataParallelTrainer* trainer = nullptr;  // One replica per core
 
 // Training parameters - reduced batch size for memory efficiency
 const int num_points = 100;         // Reduced from 20 to 10
@@ -13,6 +21,42 @@ const float learning_rate = 0.01f;
 const int max_epochs = 1000;
 const int hidden_size = 128;        // Reduced hidden layer size
 const float PI2 = 2.0f * PI;
+const int train_workers = 2;        // Data-parallel replicas, one per core
+const bool report_scaling = false;  // Time training steps for 1..train_workers
+
+// Fixed-shape copies of the trained weights for allocation-free inference
+StaticTensor<2, hidden_size> W1_static;
+StaticTensor<hidden_size, 1> W2_static;
+
+// Online learning from labelled samples received over Serial
+const int online_capacity = 64;     // Recent samples kept for replay
+const int online_batch = 8;         // Rows per online mini-step
+const float online_learning_rate = 0.005f;
+OnlineTrainer<online_capacity, 2, 1, online_batch>* online_trainer = nullptr;
+
+// Serial parsing runs on core 0 and feeds loop() on core 1 through a queue
+const int request_queue_size = 64;  // Power of two
+const int pipeline_batch = 8;       // Requests handled per loop() pass
+SpscQueue<Request, request_queue_size> request_queue;
+IngestStage<Stream, request_queue_size>* ingest = nullptr;
+unsigned long ingest_dropped = 0;   // Over-long lines already reported
+
+// loop() work buffers. The hidden activations alone are 4 KB, so they
+// live here rather than on the 8 KB loopTask stack.
+Request pipeline_requests[pipeline_batch];
+StaticTensor<pipeline_batch, 2> pipeline_input;
+StaticTensor<pipeline_batch, hidden_size> pipeline_hidden;
+StaticTensor<pipeline_batch, 1> pipeline_pred;
+
+// Lookup table baked from the trained model over one period. loop()
+// answers inputs inside [lo, hi] from it and re-bakes after online steps.
+const float bake_tolerance = 1e-3f;
+const bool print_baked_source = false;  // Dump the table as C source
+BakeOptions sin_lut_options;
+BakedLUT sin_lut;
+
+// Standalone C export of the trained network, traced at one input row
+const bool print_model_source = false;
 
 // Helper function to allocate memory in PSRAM with fallback
 void* allocateMemory(size_t size, bool prefer_psram = true) {
@@ -34,6 +78,12 @@ void printMemoryInfo() {
     if (psramFound()) {
         Serial.printf("Free PSRAM: %d bytes\n", ESP.getFreePsram());
     }
+    MemorySnapshot mem = telemetry::snapshot();
+    Serial.printf("Tensors: %ld live (peak %ld), data %ld / grad %ld / nodes %ld bytes\n",
+                  mem.live_tensors, mem.peak_tensors,
+                  mem.bytes[MEM_DATA], mem.bytes[MEM_GRAD], mem.bytes[MEM_NODES]);
+    Serial.printf("Tensor bytes: %ld now, %ld step peak, %ld peak\n",
+                  mem.total_bytes(), mem.step_peak_bytes, mem.peak_bytes);
 }
 
 float** create_data_array(int rows, int cols, std::function<float(int, int)> init_func) {
@@ -65,30 +115,43 @@ void free_data_array(float** data, int rows) {
     }
 }
 
-float mmse(Value &y_true, Value &y_pred) {
-    float result = 0.0f;
-    if (y_true.ptr->rows != y_pred.ptr->rows || y_true.ptr->cols != y_pred.ptr->cols) {
-        Serial.println("Error: shape mismatch");
-        return result;
-    }
+Value forward_with(Value &x, Value &w1, Value &w2) {
+    Value hidden = x * w1;
+    Value hidden_act = hidden.leakyrelu();
+    return hidden_act * w2;
+}
 
-    for (int i = 0; i < y_true.ptr->rows; i++) {
-        for (int j = 0; j < y_true.ptr->cols; j++) {
-            float diff = y_true.ptr->data[i][j] - y_pred.ptr->data[i][j];
-            result += diff * diff;
-        }
-    }
-    result /= static_cast<float>(y_true.ptr->rows * y_true.ptr->cols);
+Value forward(Value &x) {
+    return forward_with(x, *W1_global, *W2_global);
+}
 
-    if (y_pred.ptr->grad) {
-        float scale = 2.0f / static_cast<float>(y_pred.ptr->rows * y_pred.ptr->cols);
-        for (int i = 0; i < y_pred.ptr->rows; i++) {
-            for (int j = 0; j < y_pred.ptr->cols; j++) {
-                y_pred.ptr->grad[i][j] = scale * (y_pred.ptr->data[i][j] - y_true.ptr->data[i][j]);
-            }
+// Loss of one data-parallel shard, computed against that worker's replicas
+Value shard_loss(Value &x, Value &y, std::vector<Value> &replica) {
+    Value out = forward_with(x, replica[0], replica[1]);
+    return out.mse_loss(y);
+}
+
+// Runs the network on a batch of scalar inputs, in chunks of num_points rows
+void forward_batch(const float* xs, float* ys, int n) {
+    for (int start = 0; start < n; start += num_points) {
+        int count = n - start < num_points ? n - start : num_points;
+        Value x(count, 2, nullptr, "bake_x", false);
+        for (int i = 0; i < count; i++) {
+            x.ptr->data[i][0] = xs[start + i];
+            x.ptr->data[i][1] = 1.0f;
+        }
+        Value y = forward(x);
+        for (int i = 0; i < count; i++) {
+            ys[start + i] = y.ptr->data[i][0];
         }
     }
-    return result;
+}
+
+// Re-samples the current weights into sin_lut
+void bake_sin_lut() {
+    sin_lut = bake(forward_batch, sin_lut_options);
+    Serial.printf("Baked LUT: %d knots, %u bytes, max error %.6f\n",
+                  sin_lut.knots(), (unsigned)sin_lut.bytes(), sin_lut.max_error);
 }
 
 Value* createTrainData(int points, bool is_x_data) {
@@ -104,7 +167,7 @@ Value* createTrainData(int points, bool is_x_data) {
     if (!data) return nullptr;
     
     Value* val = new Value(points, is_x_data ? 2 : 1, data, 
-                          is_x_data ? "x_train" : "y_train");
+                          is_x_data ? "x_train" : "y_train", false);
     free_data_array(data, points);
     return val;
 }
@@ -166,22 +229,17 @@ void setup() {
     free_data_array(w2_data, hidden_size);
     printMemoryInfo();
 
+    params.add(*W1_global);
+    params.add(*W2_global);
+    params.pack();
+    trainer = new DataParallelTrainer(shard_loss, params, train_workers);
+
     // Training loop
     Serial.println("\nStarting training...");
+    telemetry::reset_peaks();
     for (int epoch = 0; epoch < max_epochs; epoch++) {
-        Value hidden = (*x_train) * (*W1_global);
-        Value hidden_act = hidden.leakyrelu();
-        Value out = hidden_act * (*W2_global);
-
-        float loss = mmse(*y_train, out);
-        
-        out.backward();
-        W1_global->update(learning_rate);
-        W2_global->update(learning_rate);
-        
-        W1_global->setgradzero();
-        W2_global->setgradzero();
-        out.setgradzero();
+        telemetry::begin_step();
+        float loss = trainer->step(*x_train->ptr, *y_train->ptr, learning_rate);
 
         if (epoch % 100 == 0) {
             Serial.printf("Epoch %d/%d: Loss = %.6f\n", epoch, max_epochs, loss);
@@ -190,38 +248,119 @@ void setup() {
         yield();
     }
 
+    if (report_scaling) {
+        std::vector<ScalingPoint> points = measure_scaling(
+            shard_loss, params, *x_train->ptr, *y_train->ptr, train_workers, 50);
+        for (size_t i = 0; i < points.size(); i++) {
+            Serial.printf("Workers %d: %.3f ms/step, speedup %.2fx, efficiency %.0f%%\n",
+                          points[i].workers, points[i].ms_per_step,
+                          points[i].speedup, points[i].efficiency * 100.0f);
+        }
+    }
+
     // Cleanup training data
     delete x_train;
     delete y_train;
     printMemoryInfo();
+    Serial.print(tensor_leak_report().c_str());
+
+    W1_global->copy_to(W1_static);
+    W2_global->copy_to(W2_static);
+
+    sin_lut_options.lo = 0.0f;
+    sin_lut_options.hi = PI2;
+    sin_lut_options.tolerance = bake_tolerance;
+    sin_lut_options.interp = Interp::Linear;  // LeakyReLU nets are piecewise linear
+    bake_sin_lut();
+    if (print_baked_source) {
+        Serial.print(sin_lut.to_c_source("sin_lut").c_str());
+    }
+
+    // The export is a development aid, so it is only traced when asked for
+    if (print_model_source) {
+        Value trace_x(1, 2, nullptr, "x", false);
+        Value trace_y = forward(trace_x);
+        CodegenStats codegen_stats;
+        std::string model_source = generate_c_source(*trace_y.ptr, *trace_x.ptr, "sin_model", &codegen_stats);
+        Serial.printf("Exported model: %d ops, %u bytes const, %u bytes scratch\n", codegen_stats.ops,
+                      (unsigned)codegen_stats.const_bytes, (unsigned)codegen_stats.scratch_bytes);
+        Serial.print(model_source.c_str());
+    }
+
+    online_trainer = new OnlineTrainer<online_capacity, 2, 1, online_batch>(
+        forward, params, online_learning_rate);
+
+    ingest = new IngestStage<Stream, request_queue_size>(Serial, request_queue);
+    if (!ingest->start(0)) {
+        Serial.println("Failed to start ingest task");
+    }
 
     Serial.println("\nModel trained! Enter a number to predict sin(x).");
+    Serial.println("Enter \"x y\" to train on a labelled sample.");
 }
 
 void loop() {
-    if (Serial.available() > 0) {
-        String input = Serial.readStringUntil('\n');
-        float x = input.toFloat();
-        
-        float** input_data = create_data_array(1, 2, [x](int i, int j) -> float {
-            return j == 1 ? 1.0f : x;
-        });
-        
-        if (input_data) {
-            Value input_tensor(1, 2, input_data, "test_input");
-            Value hidden = input_tensor * (*W1_global);
-            Value hidden_act = hidden.leakyrelu();
-            Value pred = hidden_act * (*W2_global);
-            
-            Serial.printf("sin(%.6f) ≈ %.6f\n", x, pred.ptr->data[0][0]);
-            Serial.printf("Actual: %.6f\n", sin(x));
-            
-            free_data_array(input_data, 1);
+    unsigned long dropped = ingest ? ingest->dropped() : 0;
+    if (dropped != ingest_dropped) {
+        Serial.printf("Error: ignored %lu line(s) longer than %d characters\n", dropped - ingest_dropped,
+                      RequestParser::MAX_LINE);
+        ingest_dropped = dropped;
+    }
+
+    Request* batch = pipeline_requests;
+    int n = request_queue.pop_batch(batch, pipeline_batch);
+    if (n == 0) {
+        yield();
+        return;
+    }
+
+    // Labelled samples update the model before this batch is answered
+    bool trained = false;
+    for (int i = 0; i < n; i++) {
+        if (!batch[i].labelled || !online_trainer) {
+            continue;
         }
-        
-        while (Serial.available() > 0) {
-            Serial.read();
+        float sample_x[2] = {batch[i].x, 1.0f};
+        float sample_y[1] = {batch[i].y};
+        float loss = online_trainer->observe(sample_x, sample_y);
+        if (loss >= 0.0f) {
+            trained = true;
+            Serial.printf("Online step %lu: Loss = %.6f\n", online_trainer->steps(), loss);
+        } else {
+            Serial.printf("Buffered %d/%d samples\n", online_trainer->samples(), online_batch);
+        }
+    }
+    // The static copies and the LUT only go stale when a step actually ran
+    if (trained) {
+        W1_global->copy_to(W1_static);
+        W2_global->copy_to(W2_static);
+        bake_sin_lut();
+    }
+
+    // Inputs inside the baked range are answered from the LUT; the rest
+    // share one GEMM pair. Rows past the out-of-range count hold stale
+    // values and are ignored.
+    int gemm_rows = 0;
+    for (int i = 0; i < n; i++) {
+        if (batch[i].x < sin_lut_options.lo || batch[i].x > sin_lut_options.hi) {
+            pipeline_input(gemm_rows, 0) = batch[i].x;
+            pipeline_input(gemm_rows, 1) = 1.0f;
+            gemm_rows++;
         }
     }
+    if (gemm_rows > 0) {
+        pipeline_input.mul_into(W1_static, pipeline_hidden);
+        pipeline_hidden.leakyrelu_inplace();
+        pipeline_hidden.mul_into(W2_static, pipeline_pred);
+    }
+
+    int gemm_row = 0;
+    for (int i = 0; i < n; i++) {
+        float x = batch[i].x;
+        bool in_lut = x >= sin_lut_options.lo && x <= sin_lut_options.hi;
+        float y = in_lut ? sin_lut(x) : pipeline_pred(gemm_row++, 0);
+        Serial.printf("sin(%.6f) ≈ %.6f\n", x, y);
+        Serial.printf("Actual: %.6f\n", sin(x));
+    }
     yield();
 }
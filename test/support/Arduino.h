@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdio.h>
+
+// Host stand-in for the part of the Arduino core the library headers use
+// (Serial printing in value.h), so they build in the native env.
+
+class HostSerial {
+public:
+    void print(const char* s) { fputs(s, stdout); }
+    void print(float v) { printf("%.2f", v); }
+    void println() { putchar('\n'); }
+    void println(const char* s) { puts(s); }
+};
+
+inline HostSerial Serial;
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "matrix.h"
+
+// Graph-building helpers shared by the host test suites. Ops keep an
+// intrusive_ptr to each operand, so every tensor of a test graph lives
+// on the heap behind a TensorPtr.
+
+typedef minimal::intrusive_ptr<Tensor> TensorPtr;
+
+// Moves an op result onto the heap
+inline TensorPtr node(Tensor&& t) {
+    return TensorPtr(new Tensor(std::move(t)));
+}
+
+// rows x cols values in [-scale, scale] from a fixed LCG, so every run
+// sees the same numbers
+inline TensorPtr filled(int rows, int cols, unsigned seed, float scale = 1.0f, bool requires_grad = true) {
+    TensorPtr t(new Tensor(rows, cols, nullptr, "", requires_grad));
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            seed = seed * 1103515245u + 12345u;
+            t->data[i][j] = scale * (((seed >> 8) % 2001) / 1000.0f - 1.0f);
+        }
+    }
+    return t;
+}
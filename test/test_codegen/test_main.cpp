@@ -0,0 +1,164 @@
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "fixtures.h"
+#include "codegen.h"
+
+// Compiles the generated C with the host compiler ($CC, default cc) and
+// diffs its output against the traced graph, for every Approx mode.
+
+namespace {
+
+const float TOLERANCE = 1e-5f;
+
+bool write_file(const std::string& path, const std::string& text) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        return false;
+    }
+    bool ok = fwrite(text.data(), 1, text.size(), f) == text.size();
+    return fclose(f) == 0 && ok;
+}
+
+const char* compiler() {
+    const char* cc = getenv("CC");
+    return cc && *cc ? cc : "cc";
+}
+
+// Build source + a driver that feeds input and prints every output value,
+// run it, and return the printed values. Empty on any failure.
+std::vector<float> run_generated(const std::string& source, const char* name, const Tensor& input, int outputs) {
+    std::vector<float> result;
+    char dir[] = "/tmp/nn_codegen_XXXXXX";
+    if (!mkdtemp(dir)) {
+        return result;
+    }
+    std::string base(dir);
+    std::string driver = "#include <stdio.h>\n";
+    driver += "void " + std::string(name) + "_predict(const float* in, float* out);\n";
+    driver += "static const float input[" + std::to_string(input.rows * input.cols) + "] = {";
+    for (int i = 0; i < input.rows; i++) {
+        for (int j = 0; j < input.cols; j++) {
+            driver += codegen::float_literal(input.data[i][j]) + ",";
+        }
+    }
+    driver += "};\nint main(void) {\n    float out[" + std::to_string(outputs) + "];\n";
+    driver += "    " + std::string(name) + "_predict(input, out);\n";
+    driver += "    for (int i = 0; i < " + std::to_string(outputs) + "; i++) printf(\"%.9g\\n\", out[i]);\n";
+    driver += "    return 0;\n}\n";
+
+    if (write_file(base + "/model.c", source) && write_file(base + "/driver.c", driver)) {
+        std::string build = std::string(compiler()) + " -std=c99 -O2 -o " + base + "/model " + base + "/model.c "
+                          + base + "/driver.c -lm";
+        if (system(build.c_str()) == 0) {
+            FILE* p = popen((base + "/model").c_str(), "r");
+            float v;
+            while (p && fscanf(p, "%f", &v) == 1) {
+                result.push_back(v);
+            }
+            if (p) {
+                pclose(p);
+            }
+        }
+    }
+    std::string cleanup = "rm -rf " + base;
+    int status = system(cleanup.c_str());
+    (void)status;
+    return result;
+}
+
+void check_export(const Tensor& output, const Tensor& input, const char* name) {
+    std::string source = generate_c_source(output, input, name);
+    int outputs = output.rows * output.cols;
+    std::vector<float> got = run_generated(source, name, input, outputs);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(outputs, (int)got.size(), "generated model did not build or run");
+    for (int i = 0; i < output.rows; i++) {
+        for (int j = 0; j < output.cols; j++) {
+            TEST_ASSERT_FLOAT_WITHIN_MESSAGE(TOLERANCE, output.data[i][j], got[i * output.cols + j], name);
+        }
+    }
+}
+
+enum Activation { TANH, SIGMOID, SILU, GELU };
+
+// x (3x4) * W1 (4x6) -> activation -> * W2 (6x2)
+void check_activation(Activation act, Approx approx, const char* name) {
+    TensorPtr x = filled(3, 4, 1, 3.0f, false);
+    TensorPtr w1 = filled(4, 6, 2, 1.5f);
+    TensorPtr w2 = filled(6, 2, 3, 1.0f);
+    TensorPtr h = node(*x * *w1);
+    TensorPtr a;
+    switch (act) {
+        case TANH: a = node(h->tanh(approx)); break;
+        case SIGMOID: a = node(h->sigmoid(approx)); break;
+        case SILU: a = node(h->silu(approx)); break;
+        case GELU: a = node(h->gelu(approx)); break;
+    }
+    TensorPtr y = node(*a * *w2);
+    check_export(*y, *x, name);
+}
+
+void check_all_activations(Approx approx, const std::string& mode) {
+    check_activation(TANH, approx, ("tanh_" + mode).c_str());
+    check_activation(SIGMOID, approx, ("sigmoid_" + mode).c_str());
+    check_activation(SILU, approx, ("silu_" + mode).c_str());
+    check_activation(GELU, approx, ("gelu_" + mode).c_str());
+}
+
+}
+
+void setUp() {
+    if (system((std::string(compiler()) + " --version > /dev/null 2>&1").c_str()) != 0) {
+        TEST_IGNORE_MESSAGE("no host C compiler");
+    }
+}
+
+void tearDown() {}
+
+void test_activations_exact() {
+    check_all_activations(Approx::Exact, "exact");
+}
+
+void test_activations_rational() {
+    check_all_activations(Approx::Rational, "rational");
+}
+
+void test_activations_table() {
+    check_all_activations(Approx::Table, "table");
+}
+
+void test_sparse_mixed_graph() {
+    // CSR weights in both matmuls, LeakyReLU and SiLU
+    TensorPtr x = filled(5, 8, 4, 2.0f, false);
+    TensorPtr w1 = filled(8, 16, 5, 1.0f);
+    TensorPtr w2 = filled(16, 3, 6, 1.0f);
+    w1->prune(0.7f);
+    w2->prune(0.5f);
+    TensorPtr h = node(node(*x * *w1)->lekyrelu(0.1f));
+    TensorPtr s = node(h->silu(Approx::Rational));
+    TensorPtr y = node(*s * *w2);
+    check_export(*y, *x, "mixed");
+}
+
+void test_conv1d_graph() {
+    // Strided, padded and dilated conv1d with a bias, then tanh
+    TensorPtr x = filled(11, 3, 7, 1.0f, false);
+    TensorPtr w = filled(9, 4, 8, 0.5f);
+    TensorPtr b = filled(1, 4, 9, 0.2f);
+    TensorPtr conv = node(x->conv1d(*w, 2, 1, 2));
+    TensorPtr y = node(node(conv->add_bias(*b))->tanh(Approx::Rational));
+    check_export(*y, *x, "conv");
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_activations_exact);
+    RUN_TEST(test_activations_rational);
+    RUN_TEST(test_activations_table);
+    RUN_TEST(test_sparse_mixed_graph);
+    RUN_TEST(test_conv1d_graph);
+    return UNITY_END();
+}
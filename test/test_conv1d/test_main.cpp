@@ -0,0 +1,182 @@
+#include <unity.h>
+#include <cmath>
+#include <stdexcept>
+#include "fixtures.h"
+
+// conv1d + add_bias against a direct double-precision convolution:
+// forward values, analytic gradients against central differences, the
+// CSR kernel path, and rejection of kernels wider than the input.
+
+namespace {
+
+const int LENGTH = 11;
+const int IN_CHANNELS = 3;
+const int KERNEL_SIZE = 3;
+const int OUT_CHANNELS = 4;
+
+struct Geometry {
+    int stride, padding, dilation;
+};
+
+struct Problem {
+    TensorPtr x, w, b, y;
+
+    explicit Problem(int out_len) {
+        x = TensorPtr(new Tensor(LENGTH, IN_CHANNELS, nullptr, "x"));
+        w = TensorPtr(new Tensor(KERNEL_SIZE * IN_CHANNELS, OUT_CHANNELS, nullptr, "W"));
+        b = TensorPtr(new Tensor(1, OUT_CHANNELS, nullptr, "b"));
+        y = TensorPtr(new Tensor(out_len, OUT_CHANNELS, nullptr, "y", false));
+        for (int i = 0; i < LENGTH; i++) {
+            for (int c = 0; c < IN_CHANNELS; c++) {
+                x->data[i][c] = std::sin(i * 0.7f + c) * 0.3f;
+            }
+        }
+        for (int i = 0; i < w->rows; i++) {
+            for (int o = 0; o < OUT_CHANNELS; o++) {
+                w->data[i][o] = std::cos(i * 1.3f + o * 0.4f) * 0.2f;
+            }
+        }
+        for (int o = 0; o < OUT_CHANNELS; o++) {
+            b->data[0][o] = 0.05f * o;
+            for (int t = 0; t < out_len; t++) {
+                y->data[t][o] = 0.1f * ((t + o) % 3);
+            }
+        }
+    }
+};
+
+int out_len(const Geometry& g) {
+    return (LENGTH + 2 * g.padding - g.dilation * (KERNEL_SIZE - 1) - 1) / g.stride + 1;
+}
+
+// Direct convolution in double; taps in the padding contribute nothing
+double reference_output(const Problem& p, const Geometry& g, int t, int o) {
+    double acc = p.b->data[0][o];
+    for (int k = 0; k < KERNEL_SIZE; k++) {
+        int s = t * g.stride - g.padding + k * g.dilation;
+        if (s < 0 || s >= LENGTH) {
+            continue;
+        }
+        for (int c = 0; c < IN_CHANNELS; c++) {
+            acc += (double)p.x->data[s][c] * p.w->data[k * IN_CHANNELS + c][o];
+        }
+    }
+    return acc;
+}
+
+double reference_loss(const Problem& p, const Geometry& g) {
+    int n = out_len(g);
+    double loss = 0.0;
+    for (int t = 0; t < n; t++) {
+        for (int o = 0; o < OUT_CHANNELS; o++) {
+            double d = reference_output(p, g, t, o) - p.y->data[t][o];
+            loss += d * d;
+        }
+    }
+    return loss / (n * OUT_CHANNELS);
+}
+
+// Largest |analytic - numeric| over every entry of t
+float gradient_error(const Problem& p, const Geometry& g, Tensor& t) {
+    const float eps = 1e-3f;
+    double worst = 0.0;
+    for (int i = 0; i < t.rows; i++) {
+        for (int j = 0; j < t.cols; j++) {
+            float saved = t.data[i][j];
+            t.data[i][j] = saved + eps;
+            double up = reference_loss(p, g);
+            t.data[i][j] = saved - eps;
+            double down = reference_loss(p, g);
+            t.data[i][j] = saved;
+            double numeric = (up - down) / (2.0 * eps);
+            worst = std::fmax(worst, std::fabs(numeric - t.grad[i][j]));
+        }
+    }
+    return (float)worst;
+}
+
+void check_geometry(const Geometry& g) {
+    Problem p(out_len(g));
+    TensorPtr conv = node(p.x->conv1d(*p.w, g.stride, g.padding, g.dilation));
+    TensorPtr out = node(conv->add_bias(*p.b));
+    TEST_ASSERT_EQUAL_INT(out_len(g), out->rows);
+    for (int t = 0; t < out->rows; t++) {
+        for (int o = 0; o < OUT_CHANNELS; o++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-6f, (float)reference_output(p, g, t, o), out->data[t][o]);
+        }
+    }
+
+    // Gradient norms here stay inside clip_gradient's [1e-3, 1] band, so
+    // the analytic gradients are unscaled
+    TensorPtr loss = node(out->mse_loss(*p.y));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, (float)reference_loss(p, g), loss->data[0][0]);
+    loss->backward();
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(1e-5f, gradient_error(p, g, *p.x));
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(1e-5f, gradient_error(p, g, *p.w));
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(1e-5f, gradient_error(p, g, *p.b));
+}
+
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_gradients_unit_stride() {
+    Geometry g = {1, 0, 1};
+    check_geometry(g);
+}
+
+void test_gradients_strided_padded() {
+    Geometry g = {2, 1, 1};
+    check_geometry(g);
+}
+
+void test_gradients_dilated() {
+    Geometry g = {1, 2, 2};
+    check_geometry(g);
+}
+
+void test_gradients_strided_dilated() {
+    Geometry g = {3, 1, 2};
+    check_geometry(g);
+}
+
+void test_sparse_kernel_matches_dense() {
+    Problem p(out_len(Geometry{1, 1, 1}));
+    p.w->prune(0.5f);
+    TensorPtr dense_w(new Tensor(p.w->rows, p.w->cols, p.w->data, "W dense"));
+    TensorPtr sparse = node(p.x->conv1d(*p.w, 1, 1, 1));
+    TensorPtr dense = node(p.x->conv1d(*dense_w, 1, 1, 1));
+    for (int t = 0; t < dense->rows; t++) {
+        TEST_ASSERT_EQUAL_MEMORY(dense->data[t], sparse->data[t], OUT_CHANNELS * sizeof(float));
+    }
+}
+
+void test_kernel_wider_than_input_throws() {
+    // length 3, kernel 4, stride 2: the span is negative and there is no
+    // valid window, even though truncating division would report one
+    TensorPtr x(new Tensor(3, 1, nullptr, "x"));
+    TensorPtr w(new Tensor(4, 2, nullptr, "W"));
+    bool threw = false;
+    try {
+        node(x->conv1d(*w, 2, 0, 1));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    TEST_ASSERT_TRUE(threw);
+
+    // Padding that makes the kernel fit gives exactly one window
+    TensorPtr padded = node(x->conv1d(*w, 2, 1, 1));
+    TEST_ASSERT_EQUAL_INT(1, padded->rows);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_gradients_unit_stride);
+    RUN_TEST(test_gradients_strided_padded);
+    RUN_TEST(test_gradients_dilated);
+    RUN_TEST(test_gradients_strided_dilated);
+    RUN_TEST(test_sparse_kernel_matches_dense);
+    RUN_TEST(test_kernel_wider_than_input_throws);
+    return UNITY_END();
+}
@@ -0,0 +1,228 @@
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "fixtures.h"
+#include "dataset.h"
+
+// Round trip through write_dataset and MappedDataset, chunked loading,
+// and rejection of files whose header does not match their contents.
+
+namespace {
+
+const int ROWS = 10;
+
+char path[] = "/tmp/nn_dataset_XXXXXX";
+std::vector<float32> xs;
+std::vector<float32> ys;
+
+std::vector<uint8_t> read_file() {
+    std::vector<uint8_t> bytes;
+    FILE* f = fopen(path, "rb");
+    int c;
+    while (f && (c = fgetc(f)) != EOF) {
+        bytes.push_back((uint8_t)c);
+    }
+    if (f) {
+        fclose(f);
+    }
+    return bytes;
+}
+
+void write_file(const std::vector<uint8_t>& bytes) {
+    FILE* f = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    TEST_ASSERT_EQUAL_INT((int)bytes.size(), (int)fwrite(bytes.data(), 1, bytes.size(), f));
+    fclose(f);
+}
+
+void put_u32(std::vector<uint8_t>& bytes, size_t at, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        bytes[at + i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+bool opens(const std::vector<uint8_t>& bytes) {
+    write_file(bytes);
+    MappedDataset ds;
+    return ds.open(path);
+}
+
+}
+
+// A 10-row file with a 2-wide "x" and a 1-wide "y" field
+void setUp() {
+    int fd = mkstemp(path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    close(fd);
+    xs.resize(ROWS * 2);
+    ys.resize(ROWS);
+    for (int i = 0; i < ROWS; i++) {
+        xs[2 * i] = 0.5f * i;
+        xs[2 * i + 1] = 1.0f;
+        ys[i] = -0.25f * i;
+    }
+    std::vector<DatasetField> fields;
+    fields.push_back(DatasetField{"x", 2, xs.data()});
+    fields.push_back(DatasetField{"y", 1, ys.data()});
+    TEST_ASSERT_TRUE(write_dataset(path, ROWS, fields));
+}
+
+void tearDown() {
+    unlink(path);
+    strcpy(path + strlen(path) - 6, "XXXXXX");
+}
+
+void test_round_trip() {
+    MappedDataset ds;
+    TEST_ASSERT_TRUE(ds.open(path));
+    TEST_ASSERT_EQUAL_INT(ROWS, ds.rows());
+    TEST_ASSERT_EQUAL_INT(2, ds.num_fields());
+    int x = ds.field_index("x");
+    int y = ds.field_index("y");
+    TEST_ASSERT_EQUAL_INT(0, x);
+    TEST_ASSERT_EQUAL_INT(1, y);
+    TEST_ASSERT_EQUAL_INT(-1, ds.field_index("z"));
+    TEST_ASSERT_EQUAL_INT(2, ds.width(x));
+    TEST_ASSERT_EQUAL_MEMORY(xs.data(), ds.field_data(x), xs.size() * sizeof(float32));
+    TEST_ASSERT_EQUAL_MEMORY(ys.data(), ds.field_data(y), ys.size() * sizeof(float32));
+
+    TensorPtr view(ds.view(x, 3, 4));
+    TEST_ASSERT_EQUAL_INT(4, view->rows);
+    TEST_ASSERT_EQUAL_INT(2, view->cols);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_MEMORY(&xs[2 * (3 + i)], view->data[i], 2 * sizeof(float32));
+    }
+}
+
+void test_chunk_loader_covers_every_row_once() {
+    MappedDataset ds;
+    TEST_ASSERT_TRUE(ds.open(path));
+    ChunkLoader loader(ds, 3);
+    int expected_begin = 0;
+    int chunks = 0;
+    while (loader.next()) {
+        TEST_ASSERT_EQUAL_INT(expected_begin, loader.begin());
+        TEST_ASSERT_EQUAL_INT(chunks < 3 ? 3 : 1, loader.count());
+        TensorPtr y(loader.view(ds.field_index("y")));
+        for (int i = 0; i < loader.count(); i++) {
+            TEST_ASSERT_EQUAL_FLOAT(ys[loader.begin() + i], y->data[i][0]);
+        }
+        expected_begin += loader.count();
+        chunks++;
+    }
+    TEST_ASSERT_EQUAL_INT(4, chunks);
+    TEST_ASSERT_EQUAL_INT(ROWS, expected_begin);
+
+    loader.rewind();
+    TEST_ASSERT_TRUE(loader.next());
+    TEST_ASSERT_EQUAL_INT(0, loader.begin());
+}
+
+void test_truncated_file_is_rejected() {
+    std::vector<uint8_t> bytes = read_file();
+    TEST_ASSERT_TRUE(opens(bytes));
+    // Any cut loses part of the last field block
+    std::vector<uint8_t> cut(bytes.begin(), bytes.end() - 1);
+    TEST_ASSERT_FALSE(opens(cut));
+    cut.resize(bytes.size() / 2);
+    TEST_ASSERT_FALSE(opens(cut));
+    cut.resize(8);
+    TEST_ASSERT_FALSE(opens(cut));
+}
+
+void test_bad_header_is_rejected() {
+    std::vector<uint8_t> bytes = read_file();
+
+    std::vector<uint8_t> bad = bytes;
+    bad[0] = 'X';
+    TEST_ASSERT_FALSE(opens(bad));
+
+    bad = bytes;
+    put_u32(bad, 4, DATASET_VERSION + 1);
+    TEST_ASSERT_FALSE(opens(bad));
+
+    // More rows than the blocks hold
+    bad = bytes;
+    put_u32(bad, 8, ROWS + 1);
+    TEST_ASSERT_FALSE(opens(bad));
+
+    // A field table running past the end of the file
+    bad = bytes;
+    put_u32(bad, 12, 1000);
+    TEST_ASSERT_FALSE(opens(bad));
+
+    // Misaligned and out-of-file field offsets (entry 0 at byte 16)
+    bad = bytes;
+    put_u32(bad, 16 + DATASET_NAME_LEN + 4, 18);
+    TEST_ASSERT_FALSE(opens(bad));
+    bad = bytes;
+    put_u32(bad, 16 + DATASET_NAME_LEN + 4, (uint32_t)bytes.size());
+    TEST_ASSERT_FALSE(opens(bad));
+}
+
+void test_oversized_header_fields_are_rejected() {
+    std::vector<uint8_t> bytes = read_file();
+
+    // Row count that does not fit an int
+    std::vector<uint8_t> bad = bytes;
+    put_u32(bad, 8, 0x80000000u);
+    TEST_ASSERT_FALSE(opens(bad));
+
+    bad = bytes;
+    put_u32(bad, 16 + DATASET_NAME_LEN, 0);
+    TEST_ASSERT_FALSE(opens(bad));
+
+    // rows * width * 4 wraps around to a size that fits the file
+    bad = bytes;
+    put_u32(bad, 16 + DATASET_NAME_LEN, 0xFFFFFFFFu);
+    TEST_ASSERT_FALSE(opens(bad));
+}
+
+void test_view_rejects_bad_row_ranges() {
+    MappedDataset ds;
+    TEST_ASSERT_TRUE(ds.open(path));
+    int ranges[][2] = {{-1, 2}, {3, -1}, {8, 3}, {5, INT_MAX}};
+    for (int r = 0; r < 4; r++) {
+        bool threw = false;
+        try {
+            delete ds.view(0, ranges[r][0], ranges[r][1]);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        TEST_ASSERT_TRUE(threw);
+    }
+    TensorPtr empty(ds.view(0, ROWS, 0));
+    TEST_ASSERT_EQUAL_INT(0, empty->rows);
+}
+
+void test_chunk_loader_rejects_empty_chunks() {
+    MappedDataset ds;
+    TEST_ASSERT_TRUE(ds.open(path));
+    int sizes[] = {0, -1};
+    for (int i = 0; i < 2; i++) {
+        bool threw = false;
+        try {
+            ChunkLoader loader(ds, sizes[i]);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        TEST_ASSERT_TRUE(threw);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_chunk_loader_covers_every_row_once);
+    RUN_TEST(test_truncated_file_is_rejected);
+    RUN_TEST(test_bad_header_is_rejected);
+    RUN_TEST(test_oversized_header_fields_are_rejected);
+    RUN_TEST(test_view_rejects_bad_row_ranges);
+    RUN_TEST(test_chunk_loader_rejects_empty_chunks);
+    return UNITY_END();
+}
@@ -0,0 +1,188 @@
+#include <unity.h>
+#include "fixtures.h"
+#include "fixed_point.h"
+
+// Accuracy parity of the fixed-point kernels against the float Tensor
+// path. Tolerances are in units of the format's step (one LSB).
+
+namespace {
+
+// The grad of a QTensor as values, so max_abs_error can compare it
+template <typename Q>
+Q grad_of(const Q& q) {
+    Q g(q.rows, q.cols);
+    g.data = q.grad;
+    return g;
+}
+
+template <typename Q>
+float lsb() {
+    return Q::to_float(1);
+}
+
+template <typename Q>
+void check_gemm() {
+    TensorPtr a = filled(6, 8, 1, 1.0f);
+    TensorPtr b = filled(8, 5, 2, 1.0f);
+    TensorPtr out = node(*a * *b);
+
+    Q qa = Q::from_tensor(*a);
+    Q qb = Q::from_tensor(*b);
+    Q qout;
+    fixed::gemm(qa, qb, qout);
+    // Each of the k = 8 inputs of a product is off by at most half an LSB
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(9 * lsb<Q>(), fixed::max_abs_error(qout, *out));
+}
+
+template <typename Q>
+void check_gemm_backward() {
+    TensorPtr a = filled(4, 6, 3, 0.5f);
+    TensorPtr b = filled(6, 3, 4, 0.5f);
+    TensorPtr out = node(*a * *b);
+    TensorPtr g = filled(4, 3, 5, 0.1f, false);
+    out->setGrad(g->data);
+    out->backmul();
+
+    Q qa = Q::from_tensor(*a);
+    Q qb = Q::from_tensor(*b);
+    Q qout;
+    fixed::gemm(qa, qb, qout);
+    qout.grad = Q::from_tensor(*g).data;
+    fixed::gemm_backward(qa, qb, qout);
+
+    TensorPtr ga(new Tensor(a->rows, a->cols, a->grad));
+    TensorPtr gb(new Tensor(b->rows, b->cols, b->grad));
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(7 * lsb<Q>(), fixed::max_abs_error(grad_of(qa), *ga));
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(5 * lsb<Q>(), fixed::max_abs_error(grad_of(qb), *gb));
+}
+
+template <typename Q>
+void check_leakyrelu() {
+    TensorPtr x = filled(4, 8, 6, 4.0f);
+    TensorPtr y = node(x->lekyrelu(0.01f));
+
+    Q qx = Q::from_tensor(*x);
+    Q qy;
+    fixed::leakyrelu(qx, qy, 0.01f);
+    // The slope itself is quantized, which costs up to one more LSB at |x| = 4
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(2 * lsb<Q>(), fixed::max_abs_error(qy, *y));
+}
+
+template <typename Q>
+void check_mse() {
+    TensorPtr pred = filled(4, 4, 7, 0.5f);
+    TensorPtr target = filled(4, 4, 8, 0.5f, false);
+    TensorPtr loss = node(pred->mse_loss(*target));
+    loss->backward();
+
+    Q qpred = Q::from_tensor(*pred);
+    Q qtarget = Q::from_tensor(*target);
+    float qloss = fixed::mse_loss(qpred, qtarget);
+    TEST_ASSERT_FLOAT_WITHIN(2 * lsb<Q>(), loss->data[0][0], qloss);
+
+    TensorPtr grad(new Tensor(pred->rows, pred->cols, pred->grad));
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(lsb<Q>(), fixed::max_abs_error(grad_of(qpred), *grad));
+}
+
+template <typename Q>
+void check_sgd_step(float learning_rate) {
+    TensorPtr p = filled(4, 8, 9, 1.0f);
+    TensorPtr g = filled(4, 8, 10, 1.0f, false);
+    Q qp = Q::from_tensor(*p);
+    qp.grad = Q::from_tensor(*g).data;
+    fixed::Random rng(1);
+
+    p->setGrad(g->data);
+    p->update(learning_rate);
+    fixed::sgd_step(qp, learning_rate, rng);
+    // Stochastic rounding moves each entry by at most one LSB extra
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(1.5f * lsb<Q>(), fixed::max_abs_error(qp, *p));
+}
+
+// Steps far below one LSB must still move the weights as far as the
+// float path does on average
+template <typename Q>
+void check_small_learning_rate(float learning_rate) {
+    const int steps = 200;
+    TensorPtr p = filled(8, 8, 11, 1.0f);
+    TensorPtr g = filled(8, 8, 12, 1.0f, false);
+    Q qp = Q::from_tensor(*p);
+    Q start = qp;
+    qp.grad = Q::from_tensor(*g).data;
+    fixed::Random rng(7);
+
+    p->setGrad(g->data);
+    for (int s = 0; s < steps; s++) {
+        fixed::sgd_step(qp, learning_rate, rng);
+    }
+    // Distance travelled against the gradient, summed over all entries
+    float expected = 0.0f;
+    float actual = 0.0f;
+    for (int i = 0; i < p->rows; i++) {
+        for (int j = 0; j < p->cols; j++) {
+            float sign = g->data[i][j] >= 0.0f ? 1.0f : -1.0f;
+            expected += std::fabs(g->data[i][j]) * learning_rate * steps;
+            actual += sign * (Q::to_float(start.at(i, j)) - Q::to_float(qp.at(i, j)));
+        }
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.1f * expected, expected, actual);
+}
+
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_gemm_parity() {
+    check_gemm<Q5_10Tensor>();
+    check_gemm<Q11_20Tensor>();
+}
+
+void test_gemm_backward_parity() {
+    check_gemm_backward<Q5_10Tensor>();
+    check_gemm_backward<Q11_20Tensor>();
+}
+
+void test_leakyrelu_parity() {
+    check_leakyrelu<Q5_10Tensor>();
+    check_leakyrelu<Q11_20Tensor>();
+}
+
+void test_mse_parity() {
+    check_mse<Q5_10Tensor>();
+    check_mse<Q11_20Tensor>();
+}
+
+// A Q11.20 difference of 3000 is over 2^31 raw, so its square does not
+// fit in int64 before the shift back to 20 fractional bits
+void test_mse_large_difference() {
+    Q11_20Tensor pred(44, 100), target(44, 100);
+    pred.data[123] = Q11_20Tensor::from_float(2000.0f);
+    target.data[123] = Q11_20Tensor::from_float(-1000.0f);
+    float loss = fixed::mse_loss(pred, target);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 3000.0f * 3000.0f / 4400.0f, loss);
+    TEST_ASSERT_TRUE(pred.grad[123] > 0);
+}
+
+void test_sgd_step_parity() {
+    check_sgd_step<Q5_10Tensor>(0.05f);
+    check_sgd_step<Q11_20Tensor>(0.05f);
+}
+
+void test_learning_rate_below_one_lsb() {
+    // 4e-4 is under half a Q5.10 step and used to round to a zero rate
+    check_small_learning_rate<Q5_10Tensor>(4e-4f);
+    check_small_learning_rate<Q11_20Tensor>(1e-7f);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_gemm_parity);
+    RUN_TEST(test_gemm_backward_parity);
+    RUN_TEST(test_leakyrelu_parity);
+    RUN_TEST(test_mse_parity);
+    RUN_TEST(test_mse_large_difference);
+    RUN_TEST(test_sgd_step_parity);
+    RUN_TEST(test_learning_rate_below_one_lsb);
+    return UNITY_END();
+}
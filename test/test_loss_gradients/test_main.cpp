@@ -0,0 +1,119 @@
+#include <unity.h>
+#include <functional>
+#include <vector>
+#include "fixtures.h"
+#include "scheduler.h"
+
+// backward() on a 1x1 root starts from dL/dL = 1, whichever op produced
+// it, and an mse_loss inside the graph scales by the gradient it
+// receives. Analytic gradients of W are checked against central
+// differences, sequentially and on the pool. Values are kept small so
+// clip_gradient leaves every gradient unscaled.
+
+namespace {
+
+typedef std::function<TensorPtr(const TensorPtr&)> Loss;
+
+const float EPS = 1e-2f;
+const float TOLERANCE = 1e-3f;
+
+TensorPtr x, y;
+
+float loss_value(const Loss& loss, const TensorPtr& w) {
+    return loss(w)->data[0][0];
+}
+
+void check_gradients(const Loss& loss, int rows, int cols, WorkStealingPool* pool) {
+    TensorPtr w = filled(rows, cols, 3, 0.3f);
+    TensorPtr root = loss(w);
+    if (pool) {
+        parallel_backward(root.get(), *pool);
+    } else {
+        root->backward();
+    }
+
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            float saved = w->data[i][j];
+            w->data[i][j] = saved + EPS;
+            float up = loss_value(loss, w);
+            w->data[i][j] = saved - EPS;
+            float down = loss_value(loss, w);
+            w->data[i][j] = saved;
+            TEST_ASSERT_FLOAT_WITHIN(TOLERANCE, (up - down) / (2.0f * EPS), w->grad[i][j]);
+        }
+    }
+}
+
+// sum(x * W) with a 1x1 product
+TensorPtr sum_loss(const TensorPtr& w) {
+    TensorPtr row = node(*x * *w);
+    return node(row->sum());
+}
+
+// mean(tanh(x * W))
+TensorPtr mean_loss(const TensorPtr& w) {
+    TensorPtr h = node(*x * *w);
+    return node(node(h->tanh())->mean());
+}
+
+// mse(x * W, y)
+TensorPtr mse_loss(const TensorPtr& w) {
+    TensorPtr out = node(*x * *w);
+    return node(out->mse_loss(*y));
+}
+
+// sum(mse(x * W, y) * 0.5): the mse node gets 0.5 from above
+TensorPtr scaled_mse_loss(const TensorPtr& w) {
+    TensorPtr half(new Tensor(1, 1, nullptr, "", false));
+    half->data[0][0] = 0.5f;
+    TensorPtr scaled = node(*mse_loss(w) * *half);
+    return node(scaled->sum());
+}
+
+}
+
+void setUp() {}
+void tearDown() {
+    x = nullptr;
+    y = nullptr;
+}
+
+void test_sum_root() {
+    x = filled(1, 4, 1, 0.5f, false);
+    WorkStealingPool pool(2);
+    check_gradients(sum_loss, 4, 1, nullptr);
+    check_gradients(sum_loss, 4, 1, &pool);
+}
+
+void test_mean_root() {
+    x = filled(3, 4, 1, 0.5f, false);
+    WorkStealingPool pool(2);
+    check_gradients(mean_loss, 4, 2, nullptr);
+    check_gradients(mean_loss, 4, 2, &pool);
+}
+
+void test_mse_root() {
+    x = filled(3, 4, 1, 0.5f, false);
+    y = filled(3, 2, 2, 0.5f, false);
+    WorkStealingPool pool(2);
+    check_gradients(mse_loss, 4, 2, nullptr);
+    check_gradients(mse_loss, 4, 2, &pool);
+}
+
+void test_mse_inside_graph() {
+    x = filled(3, 4, 1, 0.5f, false);
+    y = filled(3, 2, 2, 0.5f, false);
+    WorkStealingPool pool(2);
+    check_gradients(scaled_mse_loss, 4, 2, nullptr);
+    check_gradients(scaled_mse_loss, 4, 2, &pool);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sum_root);
+    RUN_TEST(test_mean_root);
+    RUN_TEST(test_mse_root);
+    RUN_TEST(test_mse_inside_graph);
+    return UNITY_END();
+}
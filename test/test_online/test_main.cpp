@@ -0,0 +1,91 @@
+#include <unity.h>
+#include "fixtures.h"
+#include "online.h"
+
+// SampleRing ordering across wraparound, and OnlineTrainer warm-up and
+// convergence on a linear target.
+
+namespace {
+
+const int CAPACITY = 4;
+
+typedef SampleRing<CAPACITY, 2, 1> Ring;
+
+void push_sample(Ring& ring, int k) {
+    float x[2] = {(float)k, (float)-k};
+    float y[1] = {0.5f * k};
+    ring.push(x, y);
+}
+
+// The ring holds samples newest - age for age in [0, size)
+void assert_holds(const Ring& ring, int newest) {
+    for (int age = 0; age < ring.size(); age++) {
+        int k = newest - age;
+        TEST_ASSERT_EQUAL_FLOAT((float)k, ring.x(age)[0]);
+        TEST_ASSERT_EQUAL_FLOAT((float)-k, ring.x(age)[1]);
+        TEST_ASSERT_EQUAL_FLOAT(0.5f * k, ring.y(age)[0]);
+    }
+}
+
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_ring_fills_in_order() {
+    Ring ring;
+    TEST_ASSERT_EQUAL_INT(0, ring.size());
+    for (int k = 1; k <= CAPACITY; k++) {
+        push_sample(ring, k);
+        TEST_ASSERT_EQUAL_INT(k, ring.size());
+        assert_holds(ring, k);
+    }
+    TEST_ASSERT_TRUE(ring.full());
+}
+
+void test_ring_wraparound_drops_oldest() {
+    Ring ring;
+    // Several full turns, ending with head in the middle of the storage
+    for (int k = 1; k <= 5 * CAPACITY + 3; k++) {
+        push_sample(ring, k);
+        TEST_ASSERT_EQUAL_INT(k < CAPACITY ? k : CAPACITY, ring.size());
+        assert_holds(ring, k);
+    }
+}
+
+void test_trainer_warms_up_then_fits() {
+    // y = 0.5 x - 0.25 with the bias as a constant second input
+    float w0 = 0.0f;
+    float* rows[2] = {&w0, &w0};
+    Value W(2, 1, rows, "W");
+    ParameterRegistry params;
+    params.add(W);
+    params.pack();
+    OnlineTrainer<16, 2, 1, 4> trainer([&W](Value& x) { return x * W; }, params, 0.1f);
+
+    float loss = 0.0f;
+    for (int i = 0; i < 600; i++) {
+        float x[2] = {(float)(i % 11) / 10.0f - 0.5f, 1.0f};
+        float y[1] = {0.5f * x[0] - 0.25f};
+        loss = trainer.observe(x, y);
+        if (i < 3) {
+            TEST_ASSERT_TRUE(loss < 0.0f);
+            TEST_ASSERT_EQUAL_INT(0, (int)trainer.steps());
+        } else {
+            TEST_ASSERT_TRUE(loss >= 0.0f);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(597, (int)trainer.steps());
+    TEST_ASSERT_EQUAL_INT(16, trainer.samples());
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(1e-4f, loss);
+    TEST_ASSERT_FLOAT_WITHIN(1e-2f, 0.5f, W.ptr->data[0][0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-2f, -0.25f, W.ptr->data[1][0]);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ring_fills_in_order);
+    RUN_TEST(test_ring_wraparound_drops_oldest);
+    RUN_TEST(test_trainer_warms_up_then_fits);
+    return UNITY_END();
+}
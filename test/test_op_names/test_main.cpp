@@ -0,0 +1,83 @@
+#include <unity.h>
+#include "fixtures.h"
+
+// label() renders the expression an op computes from the interned OpIds.
+// The suite also runs with -DNN_STRIP_NAMES=1 (env:native_stripped),
+// where label() gives only the op symbol and leaves are unnamed.
+
+namespace {
+
+TensorPtr named(int rows, int cols, unsigned seed, const char* name) {
+    TensorPtr t(new Tensor(rows, cols, nullptr, name));
+    TensorPtr values = filled(rows, cols, seed);
+    for (int i = 0; i < rows; i++) {
+        memcpy(t->data[i], values->data[i], cols * sizeof(float32));
+    }
+    return t;
+}
+
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_leaf_label() {
+    TensorPtr x = named(2, 3, 1, "x");
+#if NN_STRIP_NAMES
+    TEST_ASSERT_EQUAL_STRING("", x->label().c_str());
+#else
+    TEST_ASSERT_EQUAL_STRING("x", x->label().c_str());
+#endif
+}
+
+void test_op_labels() {
+    TensorPtr x = named(2, 3, 1, "x");
+    TensorPtr w = named(3, 3, 2, "W");
+    TensorPtr h = node(*x * *w);
+    TensorPtr a = node(h->tanh());
+    TensorPtr s = node(*a + *x);
+    TensorPtr m = node(s->mean());
+    TensorPtr loss = node(a->mse_loss(*x));
+#if NN_STRIP_NAMES
+    TEST_ASSERT_EQUAL_STRING("*", h->label().c_str());
+    TEST_ASSERT_EQUAL_STRING("tanh", a->label().c_str());
+    TEST_ASSERT_EQUAL_STRING("+", s->label().c_str());
+    TEST_ASSERT_EQUAL_STRING("mean", m->label().c_str());
+    TEST_ASSERT_EQUAL_STRING("mse", loss->label().c_str());
+#else
+    TEST_ASSERT_EQUAL_STRING("(x*W)", h->label().c_str());
+    TEST_ASSERT_EQUAL_STRING("tanh((x*W))", a->label().c_str());
+    TEST_ASSERT_EQUAL_STRING("(tanh((x*W))+x)", s->label().c_str());
+    TEST_ASSERT_EQUAL_STRING("mean((tanh((x*W))+x))", m->label().c_str());
+    TEST_ASSERT_EQUAL_STRING("mse(tanh((x*W)), x)", loss->label().c_str());
+#endif
+}
+
+void test_released_children_show_as_unknown() {
+    TensorPtr x = named(2, 3, 1, "x");
+    TensorPtr w = named(3, 1, 2, "W");
+    TensorPtr loss = node(node(*x * *w)->sum());
+    loss->backward();
+#if NN_STRIP_NAMES
+    TEST_ASSERT_EQUAL_STRING("sum", loss->label().c_str());
+#else
+    TEST_ASSERT_EQUAL_STRING("sum(?)", loss->label().c_str());
+#endif
+}
+
+void test_op_symbols() {
+    TEST_ASSERT_EQUAL_STRING("-", op_symbol(OpId::Sub));
+    TEST_ASSERT_EQUAL_STRING("^", op_symbol(OpId::Dot));
+    TEST_ASSERT_EQUAL_STRING("leakyrelu", op_symbol(OpId::LeakyRelu));
+    TEST_ASSERT_EQUAL_STRING("checkpoint", op_symbol(OpId::Checkpoint));
+    TEST_ASSERT_EQUAL_STRING("", op_symbol(OpId::Leaf));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_leaf_label);
+    RUN_TEST(test_op_labels);
+    RUN_TEST(test_released_children_show_as_unknown);
+    RUN_TEST(test_op_symbols);
+    return UNITY_END();
+}
@@ -0,0 +1,141 @@
+#include <unity.h>
+#include "fixtures.h"
+#include "parameters.h"
+
+// The flat-buffer sweeps of ParameterRegistry must match the per-tensor
+// Tensor::update / setgradzero path step for step, pruned weights included.
+
+namespace {
+
+const float LR = 0.05f;
+
+// Two-layer model; the first layer is 50% pruned when prune_w1 is set
+struct Model {
+    TensorPtr w1;
+    TensorPtr w2;
+
+    explicit Model(bool prune_w1) : w1(filled(6, 8, 11)), w2(filled(8, 3, 12)) {
+        if (prune_w1) {
+            w1->prune(0.5f);
+        }
+    }
+
+    void backward(const TensorPtr& x, const TensorPtr& y) {
+        TensorPtr h = node(*x * *w1);
+        TensorPtr a = node(h->tanh());
+        TensorPtr out = node(*a * *w2);
+        TensorPtr loss = node(out->mse_loss(*y));
+        loss->backward();
+    }
+};
+
+void assert_same_data(const Tensor& expected, const Tensor& actual) {
+    for (int i = 0; i < expected.rows; i++) {
+        for (int j = 0; j < expected.cols; j++) {
+            TEST_ASSERT_EQUAL_FLOAT(expected.data[i][j], actual.data[i][j]);
+        }
+    }
+}
+
+void assert_sparse_matches_dense(const Tensor& t) {
+    const CSRMatrix& csr = *t.sparse;
+    int kept = 0;
+    for (int i = 0; i < t.rows; i++) {
+        for (int p = csr.row_ptr[i]; p < csr.row_ptr[i + 1]; p++) {
+            TEST_ASSERT_EQUAL_FLOAT(t.data[i][csr.col_idx[p]], csr.values[p]);
+            kept++;
+        }
+    }
+    int zeros = 0;
+    for (int i = 0; i < t.rows; i++) {
+        for (int j = 0; j < t.cols; j++) {
+            zeros += t.data[i][j] == 0.0f;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(t.rows * t.cols - kept, zeros);
+}
+
+void run_parity(bool prune_w1) {
+    TensorPtr x = filled(5, 6, 1);
+    TensorPtr y = filled(5, 3, 2);
+    Model flat(prune_w1);
+    Model reference(prune_w1);
+
+    ParameterRegistry params;
+    params.add(flat.w1.get());
+    params.add(flat.w2.get());
+    params.pack();
+    TEST_ASSERT_EQUAL_INT(6 * 8 + 8 * 3, (int)params.size());
+
+    for (int step = 0; step < 10; step++) {
+        flat.backward(x, y);
+        params.step(LR);
+        params.zero_grad();
+
+        reference.backward(x, y);
+        reference.w1->update(LR);
+        reference.w2->update(LR);
+        reference.w1->setgradzero();
+        reference.w2->setgradzero();
+
+        assert_same_data(*reference.w1, *flat.w1);
+        assert_same_data(*reference.w2, *flat.w2);
+    }
+    if (prune_w1) {
+        assert_sparse_matches_dense(*flat.w1);
+    }
+}
+
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_step_matches_per_tensor_sgd() {
+    run_parity(false);
+}
+
+void test_step_matches_masked_sgd_on_pruned_weights() {
+    run_parity(true);
+}
+
+void test_zero_grad_and_grad_norm_cover_every_tensor() {
+    TensorPtr x = filled(5, 6, 3);
+    TensorPtr y = filled(5, 3, 4);
+    Model model(false);
+    ParameterRegistry params;
+    params.add(model.w1.get());
+    params.add(model.w2.get());
+    params.pack();
+    model.backward(x, y);
+
+    float sum = 0.0f;
+    const Tensor* tensors[2] = {model.w1.get(), model.w2.get()};
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < tensors[t]->rows; i++) {
+            for (int j = 0; j < tensors[t]->cols; j++) {
+                sum += tensors[t]->grad[i][j] * tensors[t]->grad[i][j];
+            }
+        }
+    }
+    TEST_ASSERT_TRUE(sum > 0.0f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, std::sqrt(sum), params.grad_norm());
+
+    params.zero_grad();
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < tensors[t]->rows; i++) {
+            for (int j = 0; j < tensors[t]->cols; j++) {
+                TEST_ASSERT_EQUAL_FLOAT(0.0f, tensors[t]->grad[i][j]);
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, params.grad_norm());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_step_matches_per_tensor_sgd);
+    RUN_TEST(test_step_matches_masked_sgd_on_pruned_weights);
+    RUN_TEST(test_zero_grad_and_grad_norm_cover_every_tensor);
+    return UNITY_END();
+}
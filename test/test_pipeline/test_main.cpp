@@ -0,0 +1,172 @@
+#include <unity.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pipeline.h"
+
+// SpscQueue full/empty behaviour and a two-thread transfer, plus the
+// request parser and the ingest stage on an in-memory stream.
+
+void setUp() {}
+void tearDown() {}
+
+void test_queue_full_and_empty() {
+    SpscQueue<int, 4> queue;
+    int v = -1;
+    TEST_ASSERT_FALSE(queue.pop(v));
+    TEST_ASSERT_EQUAL_INT(0, queue.size());
+
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(queue.push(i));
+    }
+    TEST_ASSERT_FALSE(queue.push(4));
+    TEST_ASSERT_EQUAL_INT(4, queue.size());
+
+    TEST_ASSERT_TRUE(queue.pop(v));
+    TEST_ASSERT_EQUAL_INT(0, v);
+    TEST_ASSERT_TRUE(queue.push(4));
+    TEST_ASSERT_FALSE(queue.push(5));
+
+    int out[8];
+    TEST_ASSERT_EQUAL_INT(4, queue.pop_batch(out, 8));
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_INT(i + 1, out[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(0, queue.pop_batch(out, 8));
+    TEST_ASSERT_FALSE(queue.pop(v));
+}
+
+void test_queue_indices_wrap() {
+    // Many more items than slots through a queue kept partly full
+    SpscQueue<int, 8> queue;
+    int next_in = 0;
+    int next_out = 0;
+    for (int round = 0; round < 1000; round++) {
+        while (queue.push(next_in)) {
+            next_in++;
+        }
+        int out[3];
+        int n = queue.pop_batch(out, 3);
+        TEST_ASSERT_EQUAL_INT(3, n);
+        for (int i = 0; i < n; i++) {
+            TEST_ASSERT_EQUAL_INT(next_out++, out[i]);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(next_in - next_out, queue.size());
+}
+
+void test_two_thread_transfer() {
+    // A small queue keeps both sides hitting full and empty
+    const int count = 200000;
+    static SpscQueue<int, 8> queue;
+    std::thread producer([] {
+        for (int i = 0; i < count; i++) {
+            while (!queue.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::vector<int> received;
+    received.reserve(count);
+    int batch[5];
+    while ((int)received.size() < count) {
+        int v;
+        // Alternate single pops and batches
+        if (received.size() % 2 == 0 && queue.pop(v)) {
+            received.push_back(v);
+            continue;
+        }
+        int n = queue.pop_batch(batch, 5);
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+        received.insert(received.end(), batch, batch + n);
+    }
+    producer.join();
+
+    int v;
+    TEST_ASSERT_FALSE(queue.pop(v));
+    for (int i = 0; i < count; i++) {
+        if (received[i] != i) {
+            TEST_ASSERT_EQUAL_INT(i, received[i]);
+        }
+    }
+}
+
+void test_parser_requests() {
+    RequestParser parser;
+    Request r;
+    const char* input = "1.5\n-2 0.25\r\nabc\n\n 3e-1 \n";
+    std::vector<Request> parsed;
+    for (const char* c = input; *c; c++) {
+        if (parser.feed(*c, r)) {
+            parsed.push_back(r);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(3, (int)parsed.size());
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, parsed[0].x);
+    TEST_ASSERT_FALSE(parsed[0].labelled);
+    TEST_ASSERT_EQUAL_FLOAT(-2.0f, parsed[1].x);
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, parsed[1].y);
+    TEST_ASSERT_TRUE(parsed[1].labelled);
+    TEST_ASSERT_EQUAL_FLOAT(0.3f, parsed[2].x);
+    TEST_ASSERT_FALSE(parsed[2].labelled);
+}
+
+void test_parser_drops_long_lines() {
+    RequestParser parser;
+    Request r;
+    // 31 characters fit; one more must not be read as "0.000...0" = 0
+    std::string fits = "1" + std::string(RequestParser::MAX_LINE - 1, ' ');
+    std::string too_long = "0." + std::string(RequestParser::MAX_LINE - 2, '0') + "5";
+    std::string input = fits + "\n" + too_long + "\n2\n" + too_long + too_long + "\r\n";
+    std::vector<Request> parsed;
+    for (size_t i = 0; i < input.size(); i++) {
+        if (parser.feed(input[i], r)) {
+            parsed.push_back(r);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(2, (int)parsed.size());
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, parsed[0].x);
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, parsed[1].x);
+    TEST_ASSERT_EQUAL_INT(2, (int)parser.dropped());
+}
+
+void test_ingest_poll() {
+    MemoryStream stream("0.5\n1 2\nx\n4");
+    SpscQueue<Request, 4> queue;
+    IngestStage<MemoryStream, 4> ingest(stream, queue);
+    // The unterminated "4" stays in the parser
+    TEST_ASSERT_EQUAL_INT(2, ingest.poll());
+    Request r;
+    TEST_ASSERT_TRUE(queue.pop(r));
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, r.x);
+    TEST_ASSERT_TRUE(queue.pop(r));
+    TEST_ASSERT_TRUE(r.labelled);
+    TEST_ASSERT_FALSE(queue.pop(r));
+    TEST_ASSERT_EQUAL_INT(0, (int)ingest.dropped());
+}
+
+void test_ingest_reports_dropped_lines() {
+    MemoryStream stream("123456789012345678901234567890123\n7\n");
+    SpscQueue<Request, 4> queue;
+    IngestStage<MemoryStream, 4> ingest(stream, queue);
+    TEST_ASSERT_EQUAL_INT(1, ingest.poll());
+    TEST_ASSERT_EQUAL_INT(1, (int)ingest.dropped());
+    Request r;
+    TEST_ASSERT_TRUE(queue.pop(r));
+    TEST_ASSERT_EQUAL_FLOAT(7.0f, r.x);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_queue_full_and_empty);
+    RUN_TEST(test_queue_indices_wrap);
+    RUN_TEST(test_two_thread_transfer);
+    RUN_TEST(test_parser_requests);
+    RUN_TEST(test_parser_drops_long_lines);
+    RUN_TEST(test_ingest_poll);
+    RUN_TEST(test_ingest_reports_dropped_lines);
+    return UNITY_END();
+}
@@ -0,0 +1,83 @@
+#include <unity.h>
+#include "fixtures.h"
+
+// Tensors created with requires_grad = false get no grad buffer, and
+// skipping their gradients must not change the gradients of anything
+// that does require one.
+
+namespace {
+
+struct Model {
+    TensorPtr x, y, w1, w2;
+
+    explicit Model(bool inputs_require_grad) {
+        x = filled(6, 4, 1, 1.0f, inputs_require_grad);
+        y = filled(6, 2, 2, 1.0f, inputs_require_grad);
+        w1 = filled(4, 8, 3);
+        w2 = filled(8, 2, 4);
+    }
+
+    void backward() {
+        TensorPtr h = node(*x * *w1);
+        TensorPtr a = node(h->tanh());
+        TensorPtr out = node(*a * *w2);
+        TensorPtr loss = node(out->mse_loss(*y));
+        loss->backward();
+    }
+};
+
+void assert_same_grad(const Tensor& expected, const Tensor& actual) {
+    for (int i = 0; i < expected.rows; i++) {
+        TEST_ASSERT_EQUAL_MEMORY(expected.grad[i], actual.grad[i], expected.cols * sizeof(float));
+    }
+}
+
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_constant_has_no_grad_buffer() {
+    MemorySnapshot before = telemetry::snapshot();
+    TensorPtr c = filled(3, 5, 5, 1.0f, false);
+    TEST_ASSERT_FALSE(c->requires_grad);
+    TEST_ASSERT_NULL(c->grad);
+    TEST_ASSERT_EQUAL_INT(before.bytes[MEM_GRAD], telemetry::snapshot().bytes[MEM_GRAD]);
+}
+
+void test_result_requires_grad_if_any_operand_does() {
+    TensorPtr a = filled(3, 4, 6, 1.0f, false);
+    TensorPtr b = filled(4, 2, 7, 1.0f, false);
+    TensorPtr w = filled(4, 2, 8);
+
+    TensorPtr constant = node(*a * *b);
+    TEST_ASSERT_FALSE(constant->requires_grad);
+    TEST_ASSERT_NULL(constant->grad);
+    TensorPtr activated = node(constant->tanh());
+    TEST_ASSERT_FALSE(activated->requires_grad);
+    TEST_ASSERT_NULL(activated->grad);
+
+    TensorPtr mixed = node(*a * *w);
+    TEST_ASSERT_TRUE(mixed->requires_grad);
+    TEST_ASSERT_NOT_NULL(mixed->grad);
+}
+
+void test_weight_gradients_unchanged() {
+    Model reference(true);
+    reference.backward();
+    Model constant_inputs(false);
+    constant_inputs.backward();
+
+    TEST_ASSERT_NULL(constant_inputs.x->grad);
+    TEST_ASSERT_NULL(constant_inputs.y->grad);
+    assert_same_grad(*reference.w1, *constant_inputs.w1);
+    assert_same_grad(*reference.w2, *constant_inputs.w2);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_constant_has_no_grad_buffer);
+    RUN_TEST(test_result_requires_grad_if_any_operand_does);
+    RUN_TEST(test_weight_gradients_unchanged);
+    return UNITY_END();
+}
@@ -0,0 +1,134 @@
+#include <unity.h>
+#include "fixtures.h"
+#include "scheduler.h"
+
+// parallel_backward must reproduce Tensor::backward() exactly, including
+// the per-step gradient clipping on tensors with several consumers.
+
+namespace {
+
+struct Chain {
+    TensorPtr x, y, w1, w2;
+
+    Chain() {
+        x = filled(16, 32, 1);
+        y = filled(16, 8, 2);
+        w1 = filled(32, 64, 3);
+        w2 = filled(64, 8, 4);
+    }
+
+    // Every tensor has a single consumer. The 16x32x64 matmul is large
+    // enough to be split into two tasks.
+    TensorPtr loss() {
+        TensorPtr h = node(*x * *w1);
+        TensorPtr a = node(h->tanh());
+        TensorPtr out = node(*a * *w2);
+        return node(out->mse_loss(*y));
+    }
+};
+
+struct Shared {
+    TensorPtr x, y, w1, w2, w3;
+
+    Shared() {
+        x = filled(16, 32, 1, 1.0f, false);
+        y = filled(16, 8, 2, 1.0f, false);
+        w1 = filled(32, 64, 3);
+        w2 = filled(64, 8, 4);
+        w3 = filled(64, 8, 5);
+    }
+
+    // Shared activations feed several branches, and W2 is used twice, so
+    // several consumers accumulate into the same grads. The 16x32x64
+    // matmul is large enough to be split into two tasks.
+    TensorPtr loss() {
+        TensorPtr h = node(*x * *w1);
+        TensorPtr a = node(h->tanh());
+        TensorPtr b = node(h->sigmoid());
+        TensorPtr c = node(*a + *b);
+        TensorPtr d = node(*c * *w2);
+        TensorPtr e = node(*a * *w2);
+        TensorPtr f = node(*b * *w3);
+        TensorPtr g = node(*d + *e);
+        TensorPtr out = node(*g - *f);
+        return node(out->mse_loss(*y));
+    }
+};
+
+void assert_same_grad(const Tensor& expected, const Tensor& actual) {
+    for (int i = 0; i < expected.rows; i++) {
+        TEST_ASSERT_EQUAL_MEMORY(expected.grad[i], actual.grad[i], expected.cols * sizeof(float));
+    }
+}
+
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_chain_matches_sequential() {
+    Chain reference;
+    reference.loss()->backward();
+
+    WorkStealingPool pool(4);
+    for (int run = 0; run < 5; run++) {
+        Chain m;
+        parallel_backward(m.loss().get(), pool);
+        assert_same_grad(*reference.x, *m.x);
+        assert_same_grad(*reference.w1, *m.w1);
+        assert_same_grad(*reference.w2, *m.w2);
+    }
+}
+
+void test_shared_consumers_match_sequential() {
+    Shared reference;
+    reference.loss()->backward();
+
+    WorkStealingPool pool(4);
+    for (int run = 0; run < 20; run++) {
+        Shared m;
+        parallel_backward(m.loss().get(), pool);
+        assert_same_grad(*reference.w1, *m.w1);
+        assert_same_grad(*reference.w2, *m.w2);
+        assert_same_grad(*reference.w3, *m.w3);
+    }
+}
+
+void test_square_of_shared_tensor() {
+    // x * x writes both halves into the same grad and must not be split
+    TensorPtr ref_w = filled(64, 64, 7);
+    TensorPtr w = filled(64, 64, 7);
+    TensorPtr ref_loss = node(node(*ref_w * *ref_w)->sum());
+    ref_loss->backward();
+
+    WorkStealingPool pool(4);
+    TensorPtr loss = node(node(*w * *w)->sum());
+    parallel_backward(loss.get(), pool);
+    assert_same_grad(*ref_w, *w);
+}
+
+void test_checkpoint_segment_runs_in_pool() {
+    std::shared_ptr<Tensor::Segment> segment = std::make_shared<Tensor::Segment>(
+        [](const TensorPtr& in) { return node(in->tanh()); });
+
+    Chain reference;
+    TensorPtr ref_h = node(*reference.x * *reference.w1);
+    TensorPtr ref_loss = node(node(ref_h->checkpoint(segment))->sum());
+    ref_loss->backward();
+
+    WorkStealingPool pool(2);
+    Chain m;
+    TensorPtr h = node(*m.x * *m.w1);
+    TensorPtr loss = node(node(h->checkpoint(segment))->sum());
+    parallel_backward(loss.get(), pool);
+    assert_same_grad(*reference.w1, *m.w1);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_chain_matches_sequential);
+    RUN_TEST(test_shared_consumers_match_sequential);
+    RUN_TEST(test_square_of_shared_tensor);
+    RUN_TEST(test_checkpoint_segment_runs_in_pool);
+    return UNITY_END();
+}
@@ -0,0 +1,108 @@
+#include <unity.h>
+#include <stdexcept>
+#include "fixtures.h"
+#include "value.h"
+
+// StaticTensor kernels against the runtime Tensor ops, for shapes below,
+// at and above STATIC_UNROLL_LIMIT so both the unrolled and the looped
+// paths run.
+
+namespace {
+
+const float TOLERANCE = 1e-5f;
+
+template <int R, int C>
+void assert_matches(const Tensor& expected, const StaticTensor<R, C>& actual) {
+    TEST_ASSERT_EQUAL_INT(R, expected.rows);
+    TEST_ASSERT_EQUAL_INT(C, expected.cols);
+    for (int i = 0; i < R; i++) {
+        for (int j = 0; j < C; j++) {
+            TEST_ASSERT_FLOAT_WITHIN(TOLERANCE, expected.data[i][j], actual(i, j));
+        }
+    }
+}
+
+template <int M, int K, int N>
+void check_matmul(unsigned seed) {
+    TensorPtr a = filled(M, K, seed);
+    TensorPtr b = filled(K, N, seed + 1);
+    TensorPtr product = node(*a * *b);
+    StaticTensor<M, K> sa(*a);
+    StaticTensor<K, N> sb(*b);
+    assert_matches(*product, sa * sb);
+}
+
+template <int R, int C>
+void check_elementwise(unsigned seed) {
+    TensorPtr a = filled(R, C, seed, 3.0f);
+    TensorPtr b = filled(R, C, seed + 1, 3.0f);
+    StaticTensor<R, C> sa(*a);
+    StaticTensor<R, C> sb(*b);
+
+    assert_matches(*node(*a + *b), sa + sb);
+    assert_matches(*node(*a - *b), sa - sb);
+    assert_matches(*node(a->lekyrelu(0.1f)), sa.leakyrelu(0.1f));
+    const Approx modes[] = {Approx::Exact, Approx::Rational, Approx::Table};
+    for (int m = 0; m < 3; m++) {
+        assert_matches(*node(a->tanh(modes[m])), sa.tanh(modes[m]));
+        assert_matches(*node(a->sigmoid(modes[m])), sa.sigmoid(modes[m]));
+        assert_matches(*node(a->gelu(modes[m])), sa.gelu(modes[m]));
+        assert_matches(*node(a->silu(modes[m])), sa.silu(modes[m]));
+    }
+}
+
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_matmul_unrolled() {
+    check_matmul<1, 2, 3>(1);
+    check_matmul<4, 16, 16>(2);
+}
+
+void test_matmul_looped() {
+    check_matmul<3, 17, 5>(3);
+    check_matmul<2, 5, 40>(4);
+    check_matmul<8, 128, 1>(5);
+}
+
+void test_elementwise_unrolled() {
+    check_elementwise<2, 8>(6);
+    check_elementwise<1, 1>(7);
+}
+
+void test_elementwise_looped() {
+    check_elementwise<3, 17>(8);
+    check_elementwise<8, 128>(9);
+}
+
+void test_value_round_trip() {
+    TensorPtr t = filled(2, 3, 10);
+    StaticTensor<2, 3> s(*t);
+    Value v(s, "w");
+    StaticTensor<2, 3> back;
+    v.copy_to(back);
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_MEMORY(&s.data[i], &back.data[i], sizeof(float32));
+    }
+
+    StaticTensor<3, 2> transposed;
+    bool threw = false;
+    try {
+        v.copy_to(transposed);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    TEST_ASSERT_TRUE(threw);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_matmul_unrolled);
+    RUN_TEST(test_matmul_looped);
+    RUN_TEST(test_elementwise_unrolled);
+    RUN_TEST(test_elementwise_looped);
+    RUN_TEST(test_value_round_trip);
+    return UNITY_END();
+}
@@ -0,0 +1,152 @@
+#include <unity.h>
+#include <memory>
+#include "fixtures.h"
+
+// Every tensor's charges must be returned when it is freed: after a
+// graph is built, trained through and dropped, the live count and each
+// byte category are back where they started.
+
+namespace {
+
+MemorySnapshot before;
+
+void assert_back_to_start() {
+    MemorySnapshot now = telemetry::snapshot();
+    TEST_ASSERT_EQUAL_INT(before.live_tensors, now.live_tensors);
+    TEST_ASSERT_EQUAL_INT(before.bytes[MEM_DATA], now.bytes[MEM_DATA]);
+    TEST_ASSERT_EQUAL_INT(before.bytes[MEM_GRAD], now.bytes[MEM_GRAD]);
+    TEST_ASSERT_EQUAL_INT(before.bytes[MEM_NODES], now.bytes[MEM_NODES]);
+}
+
+}
+
+void setUp() {
+    before = telemetry::snapshot();
+}
+
+void tearDown() {}
+
+void test_tensor_charges_its_shape() {
+    {
+        TensorPtr t = filled(3, 5, 1);
+        MemorySnapshot now = telemetry::snapshot();
+        TEST_ASSERT_EQUAL_INT(before.live_tensors + 1, now.live_tensors);
+        TEST_ASSERT_EQUAL_INT(before.bytes[MEM_DATA] + 15 * (long)sizeof(float32), now.bytes[MEM_DATA]);
+        TEST_ASSERT_EQUAL_INT(before.bytes[MEM_GRAD] + 15 * (long)sizeof(float32), now.bytes[MEM_GRAD]);
+        TEST_ASSERT_EQUAL_INT(before.bytes[MEM_NODES] + (long)sizeof(Tensor) + 2 * 3 * (long)sizeof(float32*),
+                              now.bytes[MEM_NODES]);
+    }
+    assert_back_to_start();
+}
+
+void test_training_step_returns_to_zero() {
+    {
+        TensorPtr x = filled(4, 3, 2);
+        TensorPtr y = filled(4, 2, 3);
+        TensorPtr w1 = filled(3, 8, 4);
+        TensorPtr w2 = filled(8, 2, 5);
+        TensorPtr h = node(*x * *w1);
+        TensorPtr a = node(h->tanh());
+        TensorPtr out = node(*a * *w2);
+        TensorPtr loss = node(out->mse_loss(*y));
+        loss->backward();
+        w1->update(0.1f);
+        w2->update(0.1f);
+    }
+    assert_back_to_start();
+}
+
+void test_copies_and_moves_return_to_zero() {
+    {
+        TensorPtr a = filled(2, 6, 6);
+        Tensor copy(*a);
+        Tensor moved(std::move(copy));
+        Tensor assigned;
+        assigned = *a;
+        assigned = moved;
+        MemorySnapshot now = telemetry::snapshot();
+        // a, copy (a moved-from shell), moved and assigned
+        TEST_ASSERT_EQUAL_INT(before.live_tensors + 4, now.live_tensors);
+        TEST_ASSERT_EQUAL_INT(before.bytes[MEM_DATA] + 3 * 12 * (long)sizeof(float32), now.bytes[MEM_DATA]);
+    }
+    assert_back_to_start();
+}
+
+void test_csr_tensors_return_to_zero() {
+    {
+        TensorPtr x = filled(4, 16, 7);
+        TensorPtr y = filled(4, 8, 8);
+        TensorPtr w = filled(16, 8, 9);
+        w->prune(0.75f);
+        TensorPtr out = node(*x * *w);
+        TensorPtr loss = node(out->mse_loss(*y));
+        loss->backward();
+        w->update(0.1f);
+
+        Tensor copy(*w);
+        Tensor assigned;
+        assigned = *w;
+        TEST_ASSERT_TRUE(copy.sparse != nullptr);
+        TEST_ASSERT_TRUE(assigned.sparse != nullptr);
+        copy.densify();
+    }
+    assert_back_to_start();
+}
+
+void test_copy_of_released_csr_charges_its_values() {
+    {
+        TensorPtr w = filled(16, 8, 12);
+        w->prune(0.75f);
+        w->release_dense();
+        long csr_bytes = (long)w->sparse->bytes();
+        MemorySnapshot released = telemetry::snapshot();
+        TEST_ASSERT_EQUAL_INT(before.bytes[MEM_DATA] + csr_bytes, released.bytes[MEM_DATA]);
+
+        Tensor copy(*w);
+        MemorySnapshot copied = telemetry::snapshot();
+        TEST_ASSERT_EQUAL_INT(released.bytes[MEM_DATA] + csr_bytes, copied.bytes[MEM_DATA]);
+        TEST_ASSERT_EQUAL_INT(released.bytes[MEM_GRAD], copied.bytes[MEM_GRAD]);
+
+        // Densifying the copy swaps its CSR charge for the dense one
+        copy.densify();
+        MemorySnapshot dense = telemetry::snapshot();
+        TEST_ASSERT_EQUAL_INT(released.bytes[MEM_DATA] + 16 * 8 * (long)sizeof(float32), dense.bytes[MEM_DATA]);
+    }
+    assert_back_to_start();
+}
+
+void test_peaks_follow_steps() {
+    telemetry::reset_peaks();
+    long start = telemetry::snapshot().total_bytes();
+    long step_bytes;
+    {
+        TensorPtr big = filled(64, 64, 10);
+        step_bytes = telemetry::snapshot().total_bytes() - start;
+    }
+    MemorySnapshot after = telemetry::snapshot();
+    TEST_ASSERT_EQUAL_INT(start, after.total_bytes());
+    TEST_ASSERT_EQUAL_INT(start + step_bytes, after.peak_bytes);
+    TEST_ASSERT_EQUAL_INT(start + step_bytes, after.step_peak_bytes);
+    TEST_ASSERT_EQUAL_INT(after.live_tensors + 1, after.peak_tensors);
+
+    // A new step starts its high-water mark from current usage
+    telemetry::begin_step();
+    {
+        TensorPtr small = filled(2, 2, 11);
+    }
+    after = telemetry::snapshot();
+    TEST_ASSERT_EQUAL_INT(start + step_bytes, after.peak_bytes);
+    TEST_ASSERT_TRUE(after.step_peak_bytes < start + step_bytes);
+    assert_back_to_start();
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_tensor_charges_its_shape);
+    RUN_TEST(test_training_step_returns_to_zero);
+    RUN_TEST(test_copies_and_moves_return_to_zero);
+    RUN_TEST(test_csr_tensors_return_to_zero);
+    RUN_TEST(test_copy_of_released_csr_charges_its_values);
+    RUN_TEST(test_peaks_follow_steps);
+    return UNITY_END();
+}